@@ -0,0 +1,713 @@
+#include "BouncBatch.hpp"
+
+#include "hash_fnv1a.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+//NOTE: the arithmetic below is written to match BouncSim::update() operation-for-operation
+// (same order, same comparisons), so lanes stay bit-identical to BouncSim.
+// step_block_scalar spells out each pass as a branch-free loop over lanes; step_block does the
+// same passes with SSE2, four lanes at a time (and must stay in step with step_block_scalar).
+
+BouncBatch::BouncBatch(BouncSim const &level_, uint32_t lanes_) : level(level_), lanes(lanes_) {
+	if (level.stream) {
+		throw std::runtime_error("BouncBatch can't share an endless level (its rules depend on where each player is).");
+	}
+
+	uint32_t padded = padded_lanes();
+	action.assign(lanes, 0);
+	target_x.assign(lanes, 0.0f);
+	target_y.assign(lanes, 0.0f);
+
+	player_x.assign(padded, 0.0f);
+	player_y.assign(padded, 0.0f);
+	player_velocity_x.assign(padded, 0.0f);
+	player_velocity_y.assign(padded, 0.0f);
+	ball_x.assign(padded, 0.0f);
+	ball_y.assign(padded, 0.0f);
+	ball_velocity_x.assign(padded, 0.0f);
+	ball_velocity_y.assign(padded, 0.0f);
+	player_state.assign(padded, 0);
+	ball_state.assign(padded, 0);
+	do_jump.assign(padded, 0);
+	do_bounce_jump.assign(padded, 0);
+	has_ended.assign(padded, 0);
+	deaths.assign(padded, 0);
+	exaggerated_frames.assign(padded, 0);
+
+	//every lane starts as a new game on the level:
+	BouncSim start;
+	start.boxes.clear(); //(only the per-game state is copied)
+	for (uint32_t lane = 0; lane < padded; ++lane) {
+		set_lane(lane, start);
+	}
+	for (uint32_t lane = lanes; lane < padded; ++lane) {
+		has_ended[lane] = 1;
+	}
+}
+
+void BouncBatch::set_lane(uint32_t lane, BouncSim const &sim) {
+	player_x[lane] = sim.player.x;
+	player_y[lane] = sim.player.y;
+	player_velocity_x[lane] = sim.player_velocity.x;
+	player_velocity_y[lane] = sim.player_velocity.y;
+	ball_x[lane] = sim.ball.x;
+	ball_y[lane] = sim.ball.y;
+	ball_velocity_x[lane] = sim.ball_velocity.x;
+	ball_velocity_y[lane] = sim.ball_velocity.y;
+	player_state[lane] = uint32_t(sim.player_state);
+	ball_state[lane] = uint32_t(sim.ball_state);
+	do_jump[lane] = sim.do_jump;
+	do_bounce_jump[lane] = sim.do_bounce_jump;
+	has_ended[lane] = sim.has_ended;
+	deaths[lane] = sim.deaths;
+	exaggerated_frames[lane] = sim.exaggerated_frames;
+}
+
+void BouncBatch::get_lane(uint32_t lane, BouncSim *sim) const {
+	sim->player = glm::vec2(player_x[lane], player_y[lane]);
+	sim->player_velocity = glm::vec2(player_velocity_x[lane], player_velocity_y[lane]);
+	sim->ball = glm::vec2(ball_x[lane], ball_y[lane]);
+	sim->ball_velocity = glm::vec2(ball_velocity_x[lane], ball_velocity_y[lane]);
+	sim->player_state = BouncSim::PlayerState(player_state[lane]);
+	sim->ball_state = BouncSim::BallState(ball_state[lane]);
+	sim->do_jump = do_jump[lane] != 0;
+	sim->do_bounce_jump = do_bounce_jump[lane] != 0;
+	sim->has_ended = has_ended[lane] != 0;
+	sim->deaths = deaths[lane];
+	sim->exaggerated_frames = exaggerated_frames[lane];
+}
+
+uint64_t BouncBatch::state_hash(uint32_t lane) const {
+	//(same fields, in the same order, as BouncSim::state_hash)
+	uint64_t hash = FNV1A_OFFSET;
+	hash = fnv1a(hash, glm::vec2(player_x[lane], player_y[lane]));
+	hash = fnv1a(hash, glm::vec2(player_velocity_x[lane], player_velocity_y[lane]));
+	hash = fnv1a(hash, glm::vec2(ball_x[lane], ball_y[lane]));
+	hash = fnv1a(hash, glm::vec2(ball_velocity_x[lane], ball_velocity_y[lane]));
+	hash = fnv1a(hash, uint32_t(player_state[lane]));
+	hash = fnv1a(hash, uint32_t(ball_state[lane]));
+	hash = fnv1a(hash, uint32_t(do_jump[lane] != 0) | uint32_t(do_bounce_jump[lane] != 0) << 1 | uint32_t(has_ended[lane] != 0) << 2);
+	hash = fnv1a(hash, deaths[lane]);
+	hash = fnv1a(hash, exaggerated_frames[lane]);
+	return hash;
+}
+
+void BouncBatch::step(float elapsed) {
+	//input (rare, so not worth vectorizing), as BouncSim::key_down / key_up / fire would apply it:
+	for (uint32_t lane = 0; lane < lanes; ++lane) {
+		uint8_t a = action[lane];
+		bool left = (a & Left) != 0;
+		bool right = (a & Right) != 0;
+		player_velocity_x[lane] = (left && !right ? -level.velocity_scale : (right && !left ? level.velocity_scale : 0.0f));
+
+		if ((a & Jump) && player_state[lane] == uint32_t(BouncSim::PlayerState::GROUND)) {
+			do_jump[lane] = 1;
+			player_state[lane] = uint32_t(BouncSim::PlayerState::AIR);
+			exaggerated_frames[lane] = 10;
+		}
+		if (a & Fire) {
+			glm::vec2 ball = glm::vec2(player_x[lane], player_y[lane]);
+			glm::vec2 velocity = glm::normalize(glm::vec2(target_x[lane], target_y[lane]) - ball) * level.ball_speed;
+			ball += level.ball_pre_shift * velocity;
+			ball_x[lane] = ball.x;
+			ball_y[lane] = ball.y;
+			ball_velocity_x[lane] = velocity.x;
+			ball_velocity_y[lane] = velocity.y;
+			ball_state[lane] = uint32_t(BouncSim::BallState::CAN_HIT);
+		}
+		//(jump and fire are presses, not holds)
+		action[lane] = a & ~uint8_t(Jump | Fire);
+	}
+
+	uint32_t padded = padded_lanes();
+	for (uint32_t begin = 0; begin < padded; begin += Block) {
+		step_block(begin, std::min(padded, begin + Block), elapsed);
+	}
+}
+
+//swept_aabb() (see swept_aabb.hpp) without branches; 'lo' and 'hi' are already grown by the moving box's radius:
+static inline bool swept_lane(float from_x, float from_y, float velocity_x, float velocity_y,
+	float lo_x, float lo_y, float hi_x, float hi_y, float max_t, float *t, uint8_t *axis) {
+	const float inf = std::numeric_limits< float >::infinity();
+
+	bool moving_x = (velocity_x != 0.0f);
+	bool moving_y = (velocity_y != 0.0f);
+	//(non-moving axes divide by zero here; those results are never selected)
+	float tx0 = (lo_x - from_x) / velocity_x;
+	float tx1 = (hi_x - from_x) / velocity_x;
+	float ty0 = (lo_y - from_y) / velocity_y;
+	float ty1 = (hi_y - from_y) / velocity_y;
+
+	float enter = (moving_x ? std::min(tx0, tx1) : -inf);
+	float leave = (moving_x ? std::max(tx1, tx0) : inf);
+	float enter_y = std::min(ty0, ty1);
+	bool y_later = moving_y && enter_y > enter;
+	enter = (y_later ? enter_y : enter);
+	leave = (moving_y ? std::min(leave, std::max(ty1, ty0)) : leave);
+
+	bool inside_x = moving_x || !(from_x < lo_x || from_x > hi_x);
+	bool inside_y = moving_y || !(from_y < lo_y || from_y > hi_y);
+
+	*t = enter;
+	*axis = (y_later ? 1 : 0);
+	return inside_x && inside_y && (enter <= leave) && !(enter < 0.0f || enter > max_t) && (leave > 0.0f);
+}
+
+void BouncBatch::step_block_scalar(uint32_t begin, uint32_t end, float elapsed) {
+	uint32_t count = end - begin;
+
+	float *px = player_x.data() + begin;
+	float *py = player_y.data() + begin;
+	float *pvx = player_velocity_x.data() + begin;
+	float *pvy = player_velocity_y.data() + begin;
+	float *bx = ball_x.data() + begin;
+	float *by = ball_y.data() + begin;
+	float *bvx = ball_velocity_x.data() + begin;
+	float *bvy = ball_velocity_y.data() + begin;
+	uint32_t *pstate = player_state.data() + begin;
+	uint32_t *bstate = ball_state.data() + begin;
+	uint32_t *jump = do_jump.data() + begin;
+	uint32_t *bounce_jump = do_bounce_jump.data() + begin;
+	uint32_t *ended = has_ended.data() + begin;
+	uint32_t *dead = deaths.data() + begin;
+	uint32_t *exaggerated = exaggerated_frames.data() + begin;
+
+	const uint32_t Ground = uint32_t(BouncSim::PlayerState::GROUND);
+	const uint32_t Air = uint32_t(BouncSim::PlayerState::AIR);
+	const uint32_t CanHit = uint32_t(BouncSim::BallState::CAN_HIT);
+	const uint32_t Free = uint32_t(BouncSim::BallState::FREE);
+
+	const glm::vec2 player_radius = level.player_radius;
+	const glm::vec2 ball_radius = level.ball_radius;
+	const glm::vec2 gravity = level.gravity;
+	const glm::vec2 player_start = level.player_start;
+	const float jump_velocity = level.jump_velocity;
+	const float bounce_velocity = level.bounce_velocity;
+
+	//boxes the ball bounces off (the level's boxes, then the ground):
+	ArrayView< BouncSim::Box > const boxes = level.map_boxes();
+	uint32_t ball_boxes = uint32_t(boxes.size()) + 1;
+	auto ball_box = [&](uint32_t b) -> BouncSim::Box const & {
+		return (b < boxes.size() ? boxes[b] : level.ground);
+	};
+
+	uint8_t live[Block]; //lanes whose game hasn't ended
+
+	//----- end check, player update -----
+	for (uint32_t i = 0; i < count; ++i) {
+		bool now_ended = ended[i] || (pstate[i] == Ground && (px[i] + player_radius.x >= 10.0f));
+		ended[i] = now_ended;
+		bool l = !now_ended;
+		live[i] = l;
+
+		exaggerated[i] -= (l && exaggerated[i] ? 1 : 0);
+
+		//gravity (only in the air):
+		bool air = l && pstate[i] == Air;
+		float vx = (air ? pvx[i] + elapsed * gravity.x : pvx[i]);
+		float vy = (air ? std::max(pvy[i] + elapsed * gravity.y, -10.0f) : pvy[i]);
+
+		//jumps:
+		vy = (l && jump[i] ? jump_velocity : vy);
+		vy = (l && bounce_jump[i] ? bounce_velocity : vy);
+
+		float x = (l ? px[i] + elapsed * vx : px[i]);
+		float y = (l ? py[i] + elapsed * vy : py[i]);
+		jump[i] = (l ? 0 : jump[i]);
+		bounce_jump[i] = (l ? 0 : bounce_jump[i]);
+
+		//fell off the map:
+		bool fell = l && y < -20.0f;
+		x = (fell ? player_start.x : x);
+		y = (fell ? player_start.y : y);
+		dead[i] += (fell ? 1 : 0);
+
+		//clamp to sides:
+		x = (l && x >= 10.0f ? 10.0f : (l && x <= -10.0f ? -10.0f : x));
+
+		pvx[i] = vx;
+		pvy[i] = vy;
+		px[i] = x;
+		py[i] = y;
+	}
+
+	//----- ball update: swept pass (BouncSim::sweep_ball) -----
+	{
+		float remaining[Block];
+		uint8_t moving[Block];
+		for (uint32_t i = 0; i < count; ++i) {
+			remaining[i] = elapsed;
+			moving[i] = live[i];
+		}
+
+		for (uint32_t bounce = 0; bounce < BouncSim::MaxBallBounces; ++bounce) {
+			float hit_t[Block];
+			uint32_t hit[Block]; //index into ball_box(), or ball_boxes for "none"
+			uint8_t hit_axis[Block];
+			for (uint32_t i = 0; i < count; ++i) {
+				hit_t[i] = remaining[i];
+				hit[i] = ball_boxes;
+				hit_axis[i] = 0;
+			}
+
+			//earliest hit, ties to the lowest index (as in BouncSim::sweep_ball):
+			for (uint32_t b = 0; b < ball_boxes; ++b) {
+				BouncSim::Box const &box = ball_box(b);
+				glm::vec2 lo = (box.position - box.radius) - ball_radius;
+				glm::vec2 hi = (box.position + box.radius) + ball_radius;
+				for (uint32_t i = 0; i < count; ++i) {
+					float t;
+					uint8_t axis;
+					bool h = swept_lane(bx[i], by[i], bvx[i], bvy[i], lo.x, lo.y, hi.x, hi.y, hit_t[i], &t, &axis);
+					bool take = moving[i] && h && (hit[i] == ball_boxes || t < hit_t[i]);
+					hit_t[i] = (take ? t : hit_t[i]);
+					hit[i] = (take ? b : hit[i]);
+					hit_axis[i] = (take ? axis : hit_axis[i]);
+				}
+			}
+
+			//advance to the hit (or the end of the step) and bounce:
+			bool any = false;
+			for (uint32_t i = 0; i < count; ++i) {
+				if (!moving[i]) continue;
+				if (hit[i] == ball_boxes) {
+					glm::vec2 step = remaining[i] * glm::vec2(bvx[i], bvy[i]);
+					bx[i] += step.x;
+					by[i] += step.y;
+					moving[i] = 0;
+					continue;
+				}
+				bx[i] += hit_t[i] * bvx[i];
+				by[i] += hit_t[i] * bvy[i];
+				BouncSim::Box const &box = ball_box(hit[i]);
+				if (hit_axis[i] == 1) {
+					bool above = by[i] > box.position.y;
+					by[i] = (above ? box.position.y + box.radius.y + ball_radius.y : box.position.y - box.radius.y - ball_radius.y);
+					bvy[i] = (above ? std::abs(bvy[i]) : -std::abs(bvy[i]));
+				} else {
+					bool right = bx[i] > box.position.x;
+					bx[i] = (right ? box.position.x + box.radius.x + ball_radius.x : box.position.x - box.radius.x - ball_radius.x);
+					bvx[i] = (right ? std::abs(bvx[i]) : -std::abs(bvx[i]));
+				}
+				remaining[i] -= hit_t[i];
+				any = true;
+			}
+			if (!any) break;
+		}
+	}
+
+	//----- ball update: discrete pass (BouncSim::move_ball) -----
+	for (uint32_t b = 0; b < ball_boxes; ++b) {
+		BouncSim::Box const &box = ball_box(b);
+		glm::vec2 box_min = box.position - box.radius;
+		glm::vec2 box_max = box.position + box.radius;
+		glm::vec2 above_y = glm::vec2(box.position.y + box.radius.y + ball_radius.y, box.position.y - box.radius.y - ball_radius.y);
+		glm::vec2 right_x = glm::vec2(box.position.x + box.radius.x + ball_radius.x, box.position.x - box.radius.x - ball_radius.x);
+		for (uint32_t i = 0; i < count; ++i) {
+			float min_x = std::max(box_min.x, bx[i] - ball_radius.x);
+			float min_y = std::max(box_min.y, by[i] - ball_radius.y);
+			float max_x = std::min(box_max.x, bx[i] + ball_radius.x);
+			float max_y = std::min(box_max.y, by[i] + ball_radius.y);
+			bool overlap = live[i] && !(min_x > max_x || min_y > max_y);
+			bool vertical = max_x - min_x > max_y - min_y;
+
+			bool above = by[i] > box.position.y;
+			bool right = bx[i] > box.position.x;
+			bool bounce_y = overlap && vertical;
+			bool bounce_x = overlap && !vertical;
+			by[i] = (bounce_y ? (above ? above_y.x : above_y.y) : by[i]);
+			bvy[i] = (bounce_y ? (above ? std::abs(bvy[i]) : -std::abs(bvy[i])) : bvy[i]);
+			bx[i] = (bounce_x ? (right ? right_x.x : right_x.y) : bx[i]);
+			bvx[i] = (bounce_x ? (right ? std::abs(bvx[i]) : -std::abs(bvx[i])) : bvx[i]);
+		}
+	}
+
+	//----- player vs. boxes (only the first box hit counts) -----
+	{
+		uint8_t collided[Block];
+		for (uint32_t i = 0; i < count; ++i) {
+			collided[i] = 0;
+		}
+		for (BouncSim::Box const &box : boxes) {
+			glm::vec2 box_min = box.position - box.radius;
+			glm::vec2 box_max = box.position + box.radius;
+			float top = box.position.y + box.radius.y;
+			float on_top = top + player_radius.y;
+			glm::vec2 side_x = glm::vec2(box.position.x - box.radius.x - player_radius.x, box.position.x + box.radius.x + player_radius.x);
+			for (uint32_t i = 0; i < count; ++i) {
+				float min_x = std::max(px[i] - player_radius.x, box_min.x);
+				float min_y = std::max(py[i] - player_radius.y, box_min.y);
+				float max_x = std::min(px[i] + player_radius.x, box_max.x);
+				float max_y = std::min(py[i] + player_radius.y, box_max.y);
+				bool hit = live[i] && !collided[i] && !(min_x > max_x || min_y > max_y);
+
+				bool landed = hit && top < py[i];
+				bool side = hit && !landed;
+				pstate[i] = (landed ? Ground : pstate[i]);
+				py[i] = (landed ? on_top : py[i]);
+				pvy[i] = (landed ? 0.0f : pvy[i]);
+				px[i] = (side ? (px[i] < box.position.x ? side_x.x : side_x.y) : px[i]);
+				collided[i] = collided[i] | uint8_t(hit);
+			}
+		}
+		for (uint32_t i = 0; i < count; ++i) {
+			//no collision while on the ground => now in the air:
+			pstate[i] = (live[i] && !collided[i] && pstate[i] == Ground ? Air : pstate[i]);
+		}
+	}
+
+	//----- ball vs. player (B.O.U.N.C. jumps) -----
+	for (uint32_t i = 0; i < count; ++i) {
+		float min_x = std::max(px[i] - player_radius.x, bx[i] - ball_radius.x);
+		float min_y = std::max(py[i] - player_radius.y, by[i] - ball_radius.y);
+		float max_x = std::min(px[i] + player_radius.x, bx[i] + ball_radius.x);
+		float max_y = std::min(py[i] + player_radius.y, by[i] + ball_radius.y);
+		bool hit = live[i] && !(min_x > max_x || min_y > max_y) && bstate[i] == CanHit;
+		bounce_jump[i] = (hit ? 1 : bounce_jump[i]);
+		bstate[i] = (hit ? Free : bstate[i]);
+	}
+}
+
+#if defined(BOX_SOA_AVX2) || defined(BOX_SOA_SSE2)
+//(BoxSoA.hpp has already included the SSE2 intrinsics headers)
+
+//lane-wise helpers matching the scalar code exactly:
+// (the operand order of min/max matters for equal values, e.g. 0.0f and -0.0f)
+static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+static inline __m128 std_min(__m128 a, __m128 b) { return _mm_min_ps(b, a); } //std::min(a,b): b < a ? b : a
+static inline __m128 std_max(__m128 a, __m128 b) { return _mm_max_ps(b, a); } //std::max(a,b): a < b ? b : a
+static inline __m128 abs_ps(__m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline __m128 neg_abs_ps(__m128 a) { return _mm_or_ps(_mm_set1_ps(-0.0f), a); }
+static inline __m128 not_ps(__m128 a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+static inline __m128 equals(uint32_t const *p, uint32_t value) {
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast< __m128i const * >(p)), _mm_set1_epi32(int32_t(value))));
+}
+static inline __m128 nonzero(uint32_t const *p) {
+	return not_ps(equals(p, 0));
+}
+//stores 1 where 'mask' is set and 0 elsewhere:
+static inline void store_flag(uint32_t *p, __m128 mask) {
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(p), _mm_srli_epi32(_mm_castps_si128(mask), 31));
+}
+static inline void store_select(uint32_t *p, __m128 mask, uint32_t value) {
+	__m128i old = _mm_loadu_si128(reinterpret_cast< __m128i const * >(p));
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(p), select(_mm_castps_si128(mask), _mm_set1_epi32(int32_t(value)), old));
+}
+
+void BouncBatch::step_block(uint32_t begin, uint32_t end, float elapsed) {
+	uint32_t count = end - begin; //(a multiple of four, since the arrays are padded)
+
+	float *px = player_x.data() + begin;
+	float *py = player_y.data() + begin;
+	float *pvx = player_velocity_x.data() + begin;
+	float *pvy = player_velocity_y.data() + begin;
+	float *bx = ball_x.data() + begin;
+	float *by = ball_y.data() + begin;
+	float *bvx = ball_velocity_x.data() + begin;
+	float *bvy = ball_velocity_y.data() + begin;
+	uint32_t *pstate = player_state.data() + begin;
+	uint32_t *bstate = ball_state.data() + begin;
+	uint32_t *jump = do_jump.data() + begin;
+	uint32_t *bounce_jump = do_bounce_jump.data() + begin;
+	uint32_t *ended = has_ended.data() + begin;
+	uint32_t *dead = deaths.data() + begin;
+	uint32_t *exaggerated = exaggerated_frames.data() + begin;
+
+	const uint32_t Ground = uint32_t(BouncSim::PlayerState::GROUND);
+	const uint32_t Air = uint32_t(BouncSim::PlayerState::AIR);
+	const uint32_t CanHit = uint32_t(BouncSim::BallState::CAN_HIT);
+	const uint32_t Free = uint32_t(BouncSim::BallState::FREE);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 inf = _mm_set1_ps(std::numeric_limits< float >::infinity());
+	const __m128 minus_inf = _mm_set1_ps(-std::numeric_limits< float >::infinity());
+	const __m128 player_radius_x = _mm_set1_ps(level.player_radius.x);
+	const __m128 player_radius_y = _mm_set1_ps(level.player_radius.y);
+	const __m128 ball_radius_x = _mm_set1_ps(level.ball_radius.x);
+	const __m128 ball_radius_y = _mm_set1_ps(level.ball_radius.y);
+	const __m128 elapsed4 = _mm_set1_ps(elapsed);
+
+	ArrayView< BouncSim::Box > const boxes = level.map_boxes();
+	uint32_t ball_boxes = uint32_t(boxes.size()) + 1;
+	auto ball_box = [&](uint32_t b) -> BouncSim::Box const & {
+		return (b < boxes.size() ? boxes[b] : level.ground);
+	};
+
+	__m128 live[Block / 4];
+
+	//----- end check, player update -----
+	{
+		glm::vec2 elapsed_gravity = elapsed * level.gravity;
+		for (uint32_t i = 0; i < count; i += 4) {
+			__m128 x = _mm_loadu_ps(px + i);
+			__m128 y = _mm_loadu_ps(py + i);
+			__m128 vx = _mm_loadu_ps(pvx + i);
+			__m128 vy = _mm_loadu_ps(pvy + i);
+
+			__m128 now_ended = _mm_or_ps(nonzero(ended + i),
+				_mm_and_ps(equals(pstate + i, Ground), _mm_cmpge_ps(_mm_add_ps(x, player_radius_x), _mm_set1_ps(10.0f))));
+			store_flag(ended + i, now_ended);
+			__m128 l = not_ps(now_ended);
+			live[i / 4] = l;
+
+			//(adding an all-ones mask subtracts one)
+			__m128 count_down = _mm_and_ps(l, nonzero(exaggerated + i));
+			__m128i ex = _mm_loadu_si128(reinterpret_cast< __m128i const * >(exaggerated + i));
+			_mm_storeu_si128(reinterpret_cast< __m128i * >(exaggerated + i), _mm_add_epi32(ex, _mm_castps_si128(count_down)));
+
+			__m128 air = _mm_and_ps(l, equals(pstate + i, Air));
+			vx = select(air, _mm_add_ps(vx, _mm_set1_ps(elapsed_gravity.x)), vx);
+			vy = select(air, std_max(_mm_add_ps(vy, _mm_set1_ps(elapsed_gravity.y)), _mm_set1_ps(-10.0f)), vy);
+
+			__m128 jumping = _mm_and_ps(l, nonzero(jump + i));
+			__m128 bouncing = _mm_and_ps(l, nonzero(bounce_jump + i));
+			vy = select(jumping, _mm_set1_ps(level.jump_velocity), vy);
+			vy = select(bouncing, _mm_set1_ps(level.bounce_velocity), vy);
+
+			x = select(l, _mm_add_ps(x, _mm_mul_ps(elapsed4, vx)), x);
+			y = select(l, _mm_add_ps(y, _mm_mul_ps(elapsed4, vy)), y);
+			store_select(jump + i, l, 0);
+			store_select(bounce_jump + i, l, 0);
+
+			__m128 fell = _mm_and_ps(l, _mm_cmplt_ps(y, _mm_set1_ps(-20.0f)));
+			x = select(fell, _mm_set1_ps(level.player_start.x), x);
+			y = select(fell, _mm_set1_ps(level.player_start.y), y);
+			__m128i d = _mm_loadu_si128(reinterpret_cast< __m128i const * >(dead + i));
+			_mm_storeu_si128(reinterpret_cast< __m128i * >(dead + i), _mm_sub_epi32(d, _mm_castps_si128(fell)));
+
+			__m128 at_right = _mm_and_ps(l, _mm_cmpge_ps(x, _mm_set1_ps(10.0f)));
+			__m128 at_left = _mm_andnot_ps(at_right, _mm_and_ps(l, _mm_cmple_ps(x, _mm_set1_ps(-10.0f))));
+			x = select(at_right, _mm_set1_ps(10.0f), select(at_left, _mm_set1_ps(-10.0f), x));
+
+			_mm_storeu_ps(pvx + i, vx);
+			_mm_storeu_ps(pvy + i, vy);
+			_mm_storeu_ps(px + i, x);
+			_mm_storeu_ps(py + i, y);
+		}
+	}
+
+	//----- ball update: swept pass -----
+	{
+		__m128 remaining[Block / 4];
+		__m128 moving[Block / 4];
+		for (uint32_t g = 0; g < count / 4; ++g) {
+			remaining[g] = elapsed4;
+			moving[g] = live[g];
+		}
+
+		for (uint32_t bounce = 0; bounce < BouncSim::MaxBallBounces; ++bounce) {
+			__m128 hit_t[Block / 4];
+			__m128i hit[Block / 4]; //index into ball_box(), or ball_boxes for "none"
+			__m128 hit_y[Block / 4]; //hit on the y axis
+			for (uint32_t g = 0; g < count / 4; ++g) {
+				hit_t[g] = remaining[g];
+				hit[g] = _mm_set1_epi32(int32_t(ball_boxes));
+				hit_y[g] = zero;
+			}
+
+			for (uint32_t b = 0; b < ball_boxes; ++b) {
+				BouncSim::Box const &box = ball_box(b);
+				glm::vec2 lo = (box.position - box.radius) - level.ball_radius;
+				glm::vec2 hi = (box.position + box.radius) + level.ball_radius;
+				__m128 lo_x = _mm_set1_ps(lo.x), lo_y = _mm_set1_ps(lo.y);
+				__m128 hi_x = _mm_set1_ps(hi.x), hi_y = _mm_set1_ps(hi.y);
+				__m128i index = _mm_set1_epi32(int32_t(b));
+				__m128i none = _mm_set1_epi32(int32_t(ball_boxes));
+				for (uint32_t g = 0; g < count / 4; ++g) {
+					if (!_mm_movemask_ps(moving[g])) continue; //(most balls are done after a bounce or two)
+					__m128 from_x = _mm_loadu_ps(bx + 4 * g);
+					__m128 from_y = _mm_loadu_ps(by + 4 * g);
+					__m128 velocity_x = _mm_loadu_ps(bvx + 4 * g);
+					__m128 velocity_y = _mm_loadu_ps(bvy + 4 * g);
+
+					//(as swept_lane)
+					__m128 moving_x = _mm_cmpneq_ps(velocity_x, zero);
+					__m128 moving_y = _mm_cmpneq_ps(velocity_y, zero);
+					__m128 tx0 = _mm_div_ps(_mm_sub_ps(lo_x, from_x), velocity_x);
+					__m128 tx1 = _mm_div_ps(_mm_sub_ps(hi_x, from_x), velocity_x);
+					__m128 ty0 = _mm_div_ps(_mm_sub_ps(lo_y, from_y), velocity_y);
+					__m128 ty1 = _mm_div_ps(_mm_sub_ps(hi_y, from_y), velocity_y);
+
+					__m128 enter = select(moving_x, std_min(tx0, tx1), minus_inf);
+					__m128 leave = select(moving_x, std_max(tx1, tx0), inf);
+					__m128 y_later = _mm_and_ps(moving_y, _mm_cmpgt_ps(std_min(ty0, ty1), enter));
+					enter = select(y_later, std_min(ty0, ty1), enter);
+					leave = select(moving_y, std_min(leave, std_max(ty1, ty0)), leave);
+
+					__m128 inside_x = _mm_or_ps(moving_x, not_ps(_mm_or_ps(_mm_cmplt_ps(from_x, lo_x), _mm_cmpgt_ps(from_x, hi_x))));
+					__m128 inside_y = _mm_or_ps(moving_y, not_ps(_mm_or_ps(_mm_cmplt_ps(from_y, lo_y), _mm_cmpgt_ps(from_y, hi_y))));
+					__m128 h = _mm_and_ps(_mm_and_ps(inside_x, inside_y), _mm_cmple_ps(enter, leave));
+					h = _mm_and_ps(h, not_ps(_mm_or_ps(_mm_cmplt_ps(enter, zero), _mm_cmpgt_ps(enter, hit_t[g]))));
+					h = _mm_and_ps(h, _mm_cmpgt_ps(leave, zero));
+
+					__m128 first = _mm_castsi128_ps(_mm_cmpeq_epi32(hit[g], none));
+					__m128 take = _mm_and_ps(_mm_and_ps(moving[g], h), _mm_or_ps(first, _mm_cmplt_ps(enter, hit_t[g])));
+					hit_t[g] = select(take, enter, hit_t[g]);
+					hit[g] = select(_mm_castps_si128(take), index, hit[g]);
+					hit_y[g] = select(take, y_later, hit_y[g]);
+				}
+			}
+
+			int any = 0;
+			__m128i none = _mm_set1_epi32(int32_t(ball_boxes));
+			for (uint32_t g = 0; g < count / 4; ++g) {
+				if (!_mm_movemask_ps(moving[g])) continue;
+				__m128 x = _mm_loadu_ps(bx + 4 * g);
+				__m128 y = _mm_loadu_ps(by + 4 * g);
+				__m128 vx = _mm_loadu_ps(bvx + 4 * g);
+				__m128 vy = _mm_loadu_ps(bvy + 4 * g);
+
+				__m128 missed = _mm_castsi128_ps(_mm_cmpeq_epi32(hit[g], none));
+				__m128 no_hit = _mm_and_ps(moving[g], missed);
+				__m128 did_hit = _mm_andnot_ps(missed, moving[g]);
+
+				//no hit: move the rest of the step and stop:
+				x = select(no_hit, _mm_add_ps(x, _mm_mul_ps(remaining[g], vx)), x);
+				y = select(no_hit, _mm_add_ps(y, _mm_mul_ps(remaining[g], vy)), y);
+				moving[g] = did_hit;
+
+				//hit: move to the contact point and bounce off the box hit:
+				x = select(did_hit, _mm_add_ps(x, _mm_mul_ps(hit_t[g], vx)), x);
+				y = select(did_hit, _mm_add_ps(y, _mm_mul_ps(hit_t[g], vy)), y);
+				for (uint32_t b = 0; b < ball_boxes; ++b) {
+					__m128 this_box = _mm_and_ps(did_hit, _mm_castsi128_ps(_mm_cmpeq_epi32(hit[g], _mm_set1_epi32(int32_t(b)))));
+					if (!_mm_movemask_ps(this_box)) continue;
+					BouncSim::Box const &box = ball_box(b);
+					__m128 vertical = _mm_and_ps(this_box, hit_y[g]);
+					__m128 horizontal = _mm_andnot_ps(hit_y[g], this_box);
+
+					__m128 above = _mm_cmpgt_ps(y, _mm_set1_ps(box.position.y));
+					__m128 right = _mm_cmpgt_ps(x, _mm_set1_ps(box.position.x));
+					y = select(vertical, select(above,
+						_mm_set1_ps(box.position.y + box.radius.y + level.ball_radius.y),
+						_mm_set1_ps(box.position.y - box.radius.y - level.ball_radius.y)), y);
+					vy = select(vertical, select(above, abs_ps(vy), neg_abs_ps(vy)), vy);
+					x = select(horizontal, select(right,
+						_mm_set1_ps(box.position.x + box.radius.x + level.ball_radius.x),
+						_mm_set1_ps(box.position.x - box.radius.x - level.ball_radius.x)), x);
+					vx = select(horizontal, select(right, abs_ps(vx), neg_abs_ps(vx)), vx);
+				}
+				remaining[g] = select(did_hit, _mm_sub_ps(remaining[g], hit_t[g]), remaining[g]);
+				any |= _mm_movemask_ps(did_hit);
+
+				_mm_storeu_ps(bx + 4 * g, x);
+				_mm_storeu_ps(by + 4 * g, y);
+				_mm_storeu_ps(bvx + 4 * g, vx);
+				_mm_storeu_ps(bvy + 4 * g, vy);
+			}
+			if (!any) break;
+		}
+	}
+
+	//----- ball update: discrete pass -----
+	for (uint32_t b = 0; b < ball_boxes; ++b) {
+		BouncSim::Box const &box = ball_box(b);
+		glm::vec2 box_min = box.position - box.radius;
+		glm::vec2 box_max = box.position + box.radius;
+		__m128 box_min_x = _mm_set1_ps(box_min.x), box_min_y = _mm_set1_ps(box_min.y);
+		__m128 box_max_x = _mm_set1_ps(box_max.x), box_max_y = _mm_set1_ps(box_max.y);
+		__m128 box_x = _mm_set1_ps(box.position.x), box_y = _mm_set1_ps(box.position.y);
+		__m128 above_y = _mm_set1_ps(box.position.y + box.radius.y + level.ball_radius.y);
+		__m128 below_y = _mm_set1_ps(box.position.y - box.radius.y - level.ball_radius.y);
+		__m128 right_x = _mm_set1_ps(box.position.x + box.radius.x + level.ball_radius.x);
+		__m128 left_x = _mm_set1_ps(box.position.x - box.radius.x - level.ball_radius.x);
+		for (uint32_t i = 0; i < count; i += 4) {
+			__m128 x = _mm_loadu_ps(bx + i);
+			__m128 y = _mm_loadu_ps(by + i);
+			__m128 min_x = std_max(box_min_x, _mm_sub_ps(x, ball_radius_x));
+			__m128 min_y = std_max(box_min_y, _mm_sub_ps(y, ball_radius_y));
+			__m128 max_x = std_min(box_max_x, _mm_add_ps(x, ball_radius_x));
+			__m128 max_y = std_min(box_max_y, _mm_add_ps(y, ball_radius_y));
+			__m128 overlap = _mm_and_ps(live[i / 4], not_ps(_mm_or_ps(_mm_cmpgt_ps(min_x, max_x), _mm_cmpgt_ps(min_y, max_y))));
+			if (!_mm_movemask_ps(overlap)) continue;
+			__m128 vertical = _mm_cmpgt_ps(_mm_sub_ps(max_x, min_x), _mm_sub_ps(max_y, min_y));
+
+			__m128 vx = _mm_loadu_ps(bvx + i);
+			__m128 vy = _mm_loadu_ps(bvy + i);
+			__m128 above = _mm_cmpgt_ps(y, box_y);
+			__m128 right = _mm_cmpgt_ps(x, box_x);
+			__m128 bounce_y = _mm_and_ps(overlap, vertical);
+			__m128 bounce_x = _mm_andnot_ps(vertical, overlap);
+			_mm_storeu_ps(by + i, select(bounce_y, select(above, above_y, below_y), y));
+			_mm_storeu_ps(bvy + i, select(bounce_y, select(above, abs_ps(vy), neg_abs_ps(vy)), vy));
+			_mm_storeu_ps(bx + i, select(bounce_x, select(right, right_x, left_x), x));
+			_mm_storeu_ps(bvx + i, select(bounce_x, select(right, abs_ps(vx), neg_abs_ps(vx)), vx));
+		}
+	}
+
+	//----- player vs. boxes (only the first box hit counts) -----
+	{
+		__m128 collided[Block / 4];
+		for (uint32_t g = 0; g < count / 4; ++g) {
+			collided[g] = zero;
+		}
+		for (BouncSim::Box const &box : boxes) {
+			glm::vec2 box_min = box.position - box.radius;
+			glm::vec2 box_max = box.position + box.radius;
+			__m128 box_min_x = _mm_set1_ps(box_min.x), box_min_y = _mm_set1_ps(box_min.y);
+			__m128 box_max_x = _mm_set1_ps(box_max.x), box_max_y = _mm_set1_ps(box_max.y);
+			float top = box.position.y + box.radius.y;
+			__m128 top4 = _mm_set1_ps(top);
+			__m128 on_top = _mm_set1_ps(top + level.player_radius.y);
+			__m128 box_x = _mm_set1_ps(box.position.x);
+			__m128 left_x = _mm_set1_ps(box.position.x - box.radius.x - level.player_radius.x);
+			__m128 right_x = _mm_set1_ps(box.position.x + box.radius.x + level.player_radius.x);
+			for (uint32_t i = 0; i < count; i += 4) {
+				__m128 x = _mm_loadu_ps(px + i);
+				__m128 y = _mm_loadu_ps(py + i);
+				__m128 min_x = std_max(_mm_sub_ps(x, player_radius_x), box_min_x);
+				__m128 min_y = std_max(_mm_sub_ps(y, player_radius_y), box_min_y);
+				__m128 max_x = std_min(_mm_add_ps(x, player_radius_x), box_max_x);
+				__m128 max_y = std_min(_mm_add_ps(y, player_radius_y), box_max_y);
+				__m128 h = _mm_andnot_ps(collided[i / 4], live[i / 4]);
+				h = _mm_and_ps(h, not_ps(_mm_or_ps(_mm_cmpgt_ps(min_x, max_x), _mm_cmpgt_ps(min_y, max_y))));
+				if (!_mm_movemask_ps(h)) continue;
+
+				__m128 landed = _mm_and_ps(h, _mm_cmplt_ps(top4, y));
+				__m128 side = _mm_andnot_ps(landed, h);
+				store_select(pstate + i, landed, Ground);
+				_mm_storeu_ps(py + i, select(landed, on_top, y));
+				_mm_storeu_ps(pvy + i, select(landed, zero, _mm_loadu_ps(pvy + i)));
+				_mm_storeu_ps(px + i, select(side, select(_mm_cmplt_ps(x, box_x), left_x, right_x), x));
+				collided[i / 4] = _mm_or_ps(collided[i / 4], h);
+			}
+		}
+		for (uint32_t i = 0; i < count; i += 4) {
+			__m128 lift_off = _mm_andnot_ps(collided[i / 4], _mm_and_ps(live[i / 4], equals(pstate + i, Ground)));
+			store_select(pstate + i, lift_off, Air);
+		}
+	}
+
+	//----- ball vs. player (B.O.U.N.C. jumps) -----
+	for (uint32_t i = 0; i < count; i += 4) {
+		__m128 x = _mm_loadu_ps(px + i);
+		__m128 y = _mm_loadu_ps(py + i);
+		__m128 ball_x4 = _mm_loadu_ps(bx + i);
+		__m128 ball_y4 = _mm_loadu_ps(by + i);
+		__m128 min_x = std_max(_mm_sub_ps(x, player_radius_x), _mm_sub_ps(ball_x4, ball_radius_x));
+		__m128 min_y = std_max(_mm_sub_ps(y, player_radius_y), _mm_sub_ps(ball_y4, ball_radius_y));
+		__m128 max_x = std_min(_mm_add_ps(x, player_radius_x), _mm_add_ps(ball_x4, ball_radius_x));
+		__m128 max_y = std_min(_mm_add_ps(y, player_radius_y), _mm_add_ps(ball_y4, ball_radius_y));
+		__m128 h = _mm_and_ps(live[i / 4], not_ps(_mm_or_ps(_mm_cmpgt_ps(min_x, max_x), _mm_cmpgt_ps(min_y, max_y))));
+		h = _mm_and_ps(h, equals(bstate + i, CanHit));
+		store_select(bounce_jump + i, h, 1);
+		store_select(bstate + i, h, Free);
+	}
+}
+
+#else //no SSE2
+
+void BouncBatch::step_block(uint32_t begin, uint32_t end, float elapsed) {
+	step_block_scalar(begin, end, elapsed);
+}
+
+#endif
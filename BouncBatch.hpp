@@ -0,0 +1,71 @@
+#pragma once
+
+#include "BouncSim.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * BouncBatch steps many independent games of B.O.U.N.C. at once (for bots and level validation).
+ *
+ * Each game ("lane") has its own player and ball state, stored as one array per field;
+ *  the level (boxes, ground, game constants) is read from one shared BouncSim, which must outlive the batch.
+ * step() runs BouncSim::update()'s logic on every lane, branch-free, for a block of lanes at a time
+ *  (one pass per box): with SSE2, four lanes per instruction; otherwise with plain loops.
+ *
+ * A lane ends up bit-for-bit identical to a BouncSim stepped with the same input and the Scalar
+ *  collision path (every box is tested; the shared level is expected to be small, like the game's own).
+ *
+ * Only fixed levels (the original court, or a LevelFile) can be shared: an endless level
+ *  (BouncSim::enable_streaming) plays by different rules -- no edges to win at or be clamped to,
+ *  and boxes and ground that follow the player -- which lanes, each somewhere else, can't follow.
+ */
+
+struct BouncBatch {
+	//NOTE: throws if 'level' is an endless level
+	BouncBatch(BouncSim const &level, uint32_t lanes);
+
+	BouncSim const &level;
+	uint32_t const lanes;
+
+	//----- input -----
+	// per-lane actions, applied at the start of the next step():
+	enum Action : uint8_t {
+		Left = 1, //run left while set (like holding 'a')
+		Right = 2, //run right while set (like holding 'd'); neither (or both) => stand still
+		Jump = 4, //like pressing space
+		Fire = 8, //like clicking at (target_x, target_y)
+	};
+	std::vector< uint8_t > action;
+	std::vector< float > target_x, target_y;
+
+	//advance every lane by 'elapsed' seconds:
+	void step(float elapsed);
+
+	//copy a lane's state from / to a BouncSim (e.g., to start lanes from a saved game or draw one):
+	void set_lane(uint32_t lane, BouncSim const &sim);
+	void get_lane(uint32_t lane, BouncSim *sim) const;
+
+	//same value as BouncSim::state_hash() for the lane's state:
+	uint64_t state_hash(uint32_t lane) const;
+
+	//----- per-lane state (same meaning as the BouncSim members of the same names) -----
+	std::vector< float > player_x, player_y, player_velocity_x, player_velocity_y;
+	std::vector< float > ball_x, ball_y, ball_velocity_x, ball_velocity_y;
+	//(flags are 32 bits wide, like the floats, so they can be used as SIMD masks directly)
+	std::vector< uint32_t > player_state; //BouncSim::PlayerState
+	std::vector< uint32_t > ball_state; //BouncSim::BallState
+	std::vector< uint32_t > do_jump, do_bounce_jump, has_ended;
+	std::vector< uint32_t > deaths, exaggerated_frames;
+
+	//----- internals -----
+	//lanes are updated this many at a time, so a block's state stays in cache between passes:
+	static constexpr uint32_t Block = 64;
+	//arrays are padded to a multiple of four lanes; padding lanes are games that have already ended:
+	uint32_t padded_lanes() const { return (lanes + 3) / 4 * 4; }
+	void step_block(uint32_t begin, uint32_t end, float elapsed);
+	//plain-loop version of step_block (the reference the SIMD version must match):
+	void step_block_scalar(uint32_t begin, uint32_t end, float elapsed);
+};
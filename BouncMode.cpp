@@ -6,105 +6,64 @@
 //for glm::value_ptr() :
 #include <glm/gtc/type_ptr.hpp>
 
-#include <random>
-
-BouncMode::BouncMode() {
+//for PROFILE_ZONE():
+#include "profile_zones.hpp"
 
-	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
+//for STARTUP_STAGE():
+#include "startup_report.hpp"
 
-	{ //vertex array mapping buffer for color_texture_program:
-		//ask OpenGL to fill vertex_buffer_for_color_texture_program with the name of an unused vertex array object:
-		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer_for_color_texture_program as the current vertex array object:
-		glBindVertexArray(vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-
-		//set up the vertex array object to describe arrays of BouncMode::Vertex:
-		glVertexAttribPointer(
-			color_texture_program.Position_vec4, //attribute
-			3, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 0 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Position_vec4);
-		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
-
-		glVertexAttribPointer(
-			color_texture_program.Color_vec4, //attribute
-			4, //size
-			GL_UNSIGNED_BYTE, //type
-			GL_TRUE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Color_vec4);
-
-		glVertexAttribPointer(
-			color_texture_program.TexCoord_vec2, //attribute
-			2, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 + 4*1 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
-
-		//done referring to vertex_buffer, so unbind it:
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+#include "LevelFile.hpp"
+#include "LevelStream.hpp"
 
-		//done setting up vertex array object, so unbind it:
-		glBindVertexArray(0);
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <new>
+#include <random>
 
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+//some nice colors from the course web page:
+#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
+// made bg_color a tad darker for night feel
+static const glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x102538ff);
+static const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xf2d2b6ff);
+// made this a bit darker for backgorund buildings
+static const glm::u8vec4 shadow_color = HEX_TO_U8VEC4(0x6b3d32ff);
+// even darker variant of above
+static const glm::u8vec4 shadow2_color = HEX_TO_U8VEC4(0x291713ff);
+// for rim of moon image
+static const glm::u8vec4 moon_outline_color = HEX_TO_U8VEC4(0x347cbaff);
+// for moon and stars
+static const glm::u8vec4 moon_core_color = HEX_TO_U8VEC4(0xffe7e3ff);
+// for player
+static const glm::u8vec4 player_color = HEX_TO_U8VEC4(0xb3391bff);
+// for ball
+static const glm::u8vec4 ball_color = HEX_TO_U8VEC4(0xff8161ff);
+#undef HEX_TO_U8VEC4
+
+BouncMode::BouncMode(bool endless, std::string const &level) {
+	if (!level.empty()) {
+		STARTUP_STAGE("level file map");
+		sim.use_level_file(LevelFile::open(level));
+	} else if (endless) {
+		STARTUP_STAGE("level streaming");
+		sim.enable_streaming();
+		prev_player = sim.player;
+		prev_ball = sim.ball;
 	}
 
-	{ //solid white texture:
-		//ask OpenGL to fill white_tex with the name of an unused texture object:
-		glGenTextures(1, &white_tex);
-
-		//bind that texture object as a GL_TEXTURE_2D-type texture:
-		glBindTexture(GL_TEXTURE_2D, white_tex);
-
-		//upload a 1x1 image of solid white to the texture:
-		glm::uvec2 size = glm::uvec2(1,1);
-		std::vector< glm::u8vec4 > data(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-
-		//set filtering and wrapping parameters:
-		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		//since texture uses a mipmap and we haven't uploaded one, instruct opengl to make one for us:
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		//Okay, texture uploaded, can unbind it:
-		glBindTexture(GL_TEXTURE_2D, 0);
+	//----- allocate OpenGL resources -----
+	{ //static rect buffer:
+		// (rect_stream made its own buffer)
+		STARTUP_STAGE("vertex buffer");
+		glGenBuffers(1, &static_rect_buffer);
+		//(filled by upload_static_geometry() once the scenery exists, below)
 
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
 
-    {
-        // construct the map - this could (should) be done via asset pipeline
-        boxes.emplace_back(glm::vec2(-10.0f, -3.0f), glm::vec2(0.6f, 3.0f));
-        boxes.emplace_back(glm::vec2(-6.0f, -3.0f), glm::vec2(0.6f, 3.0f));
-        boxes.emplace_back(glm::vec2(-1.0f, -3.0f), glm::vec2(0.6f, 3.0f));
-        boxes.emplace_back(glm::vec2(3.0f, -2.0f), glm::vec2(0.6f, 4.0f));
-        boxes.emplace_back(glm::vec2(7.0f, -4.0f), glm::vec2(0.6f, 2.0f));
-        boxes.emplace_back(glm::vec2(10.0f, -4.0f), glm::vec2(0.6f, 2.0f));
+    if (!endless && !sim.level_file) {
+        STARTUP_STAGE("scenery generation");
+        // (the map boxes themselves are built by BouncSim)
 
         // randomly generate background scenery for  a r t
         static std::mt19937 mt;
@@ -124,308 +83,217 @@ BouncMode::BouncMode() {
             shadow2_boxes.emplace_back(glm::vec2(x, -3.0f + (h - 3.0f)), glm::vec2(w, h));
         }
 
-        // generate stars - this should probably be done in a shader instead
-        for (uint32_t i = 0; i < 50; ++i) {
-            float x = (mt() / float(mt.max())) * 20.0f - 10.0f;
-            float y = (mt() / float(mt.max())) * 10.0f - 5.0f;
-            stars.emplace_back(glm::vec2(x, y), glm::vec2(0.03f, 0.03f));
-        }
+        // (stars are done in a shader; see SkyProgram)
     }
+
+	{ //scenery and map boxes don't move, so they're uploaded once rather than every frame:
+		// (endless levels have nothing to upload until sync() fills in the chunks around the player; draw() does it then)
+		STARTUP_STAGE("static geometry upload");
+		upload_static_geometry();
+	}
 }
 
 BouncMode::~BouncMode() {
+	if (drawn_frames) {
+		std::cout << "BouncMode uploaded " << stream_bytes / drawn_frames << " bytes of rectangles per frame over " << drawn_frames << " frames"
+			<< " (plus " << static_bytes << " bytes of static geometry)." << std::endl;
+	}
 
 	//----- free OpenGL resources -----
-	glDeleteBuffers(1, &vertex_buffer);
-	vertex_buffer = 0;
+	glDeleteBuffers(1, &static_rect_buffer);
+	static_rect_buffer = 0;
+
+	glDeleteVertexArrays(1, &rect_stream_for_rect_program);
+	rect_stream_for_rect_program = 0;
 
-	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
-	vertex_buffer_for_color_texture_program = 0;
+	glDeleteVertexArrays(1, &static_rect_buffer_for_rect_program);
+	static_rect_buffer_for_rect_program = 0;
 
-	glDeleteTextures(1, &white_tex);
-	white_tex = 0;
+	glDeleteVertexArrays(1, &empty_vertex_array);
+	empty_vertex_array = 0;
 }
 
-bool BouncMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
-    // on keydown, set player velocity, and if space, start jumping
-	if (evt.type == SDL_KEYDOWN) {
-        switch(evt.key.keysym.sym) {
-            case SDLK_w:
-                player_velocity.y = velocity_scale;
-                break;
-            case SDLK_s:
-                player_velocity.y = -velocity_scale;
-                break;
-            case SDLK_a:
-                player_velocity.x = -velocity_scale;
-                break;
-            case SDLK_d:
-                player_velocity.x = velocity_scale;
-                break;
-            case SDLK_SPACE:
-                if (player_state == PlayerState::GROUND) {
-                    do_jump = true;
-                    player_state = PlayerState::AIR;
-                    // hyperextended frame time for animation oomph
-                    exaggerated_frames = 10;
-                }
-                break;
-        }
-    }
+void BouncMode::create_vertex_array() {
+	STARTUP_STAGE("vertex array setup");
+	//vertex arrays mapping buffers for rect_program:
+	// (vertex array objects aren't shared between OpenGL contexts, so this happens on first draw,
+	//  on the main context, rather than in the constructor, which may run on a ModeLoader thread)
 
-    // on keyup, stop moving
-    else if (evt.type == SDL_KEYUP) {
-        switch(evt.key.keysym.sym) {
-            case SDLK_w:
-            case SDLK_s:
-                player_velocity.y = 0.0f;
-                break;
-            case SDLK_a:
-            case SDLK_d:
-                player_velocity.x = 0.0f;
-                break;
-        }
-    }
+	//both buffers hold InstancedRectProgram::Rect, so their vertex arrays are set up the same way:
+	auto make_vertex_array = [this](GLuint buffer) {
+		//ask OpenGL for the name of an unused vertex array object:
+		GLuint vertex_array = 0;
+		glGenVertexArrays(1, &vertex_array);
 
-    // on mouse click, fire the B.O.U.N.C. projectile (ball)
-    else if (evt.type == SDL_MOUSEBUTTONDOWN) {
-        glm::vec2 clip_mouse = glm::vec2(
-			(evt.button.x + 0.5f) / window_size.x * 2.0f - 1.0f,
-			(evt.button.y + 0.5f) / window_size.y *-2.0f + 1.0f
-		);
-
-        // shoot the ball from the player
-        ball = player;
-        ball_velocity = glm::normalize((clip_to_court * glm::vec3(clip_mouse, 1.0f)) - ball) * 15.0f;
-		// pre-shift the ball a bit so that the player can't cheese by firing upwards
-		const float pre_shift = 0.03f;
-		ball += pre_shift * ball_velocity;
-        // ball starts being able to hit the player to cause a B.O.U.N.C. jump
-        ball_state = BallState::CAN_HIT;
-    }
+		//set it as the current vertex array object, and point it at the buffer's rectangles:
+		glBindVertexArray(vertex_array);
+		rect_program.bind_rects(buffer);
+
+		//done setting up vertex array object, so unbind it:
+		glBindVertexArray(0);
+
+		return vertex_array;
+	};
+
+	rect_stream_for_rect_program = make_vertex_array(rect_stream.buffer);
+	static_rect_buffer_for_rect_program = make_vertex_array(static_rect_buffer);
+
+	//the sky has no attributes, so its vertex array object is left empty:
+	glGenVertexArrays(1, &empty_vertex_array);
 
-	return false;
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 }
 
-void BouncMode::update(float elapsed) {
-	// check if the game was won
-	// game is won if player is grounded and touching the right edge
-	if (player_state == PlayerState::GROUND && (player.x + player_radius.x >= 10.0f)) {
-		has_ended = true;
-	}
+void BouncMode::upload_static_geometry() {
+	PROFILE_ZONE("BouncMode::upload_static_geometry");
+	static_level_version = drawing.level_version;
 
-	// do no updates if game has ended
-	if (has_ended) return;
+	// scenery layers: a level file's are read straight from the file
+	// (only level files have star rectangles; otherwise the sky pass draws all the stars)
+	const ArrayView<Box> star_layer = (sim.level_file ? sim.level_file->stars() : ArrayView<Box>());
+	const ArrayView<Box> shadow2_layer = (sim.level_file ? sim.level_file->shadow2_boxes() : ArrayView<Box>(shadow2_boxes));
+	const ArrayView<Box> shadow_layer = (sim.level_file ? sim.level_file->shadow_boxes() : ArrayView<Box>(shadow_boxes));
+	// map: on endless levels, the sim thread rebuilds sim.boxes as the player moves, so only ever read the copy sync() made
+	const ArrayView<Box> map_layer = (sim.stream ? ArrayView<Box>(drawing.boxes) : sim.map_boxes());
 
-    // ----player state update----
-    // only apply gravity when in the air
-	if (player_state == PlayerState::AIR) {
-        player_velocity += elapsed * gravity;
-        player_velocity.y = std::max(player_velocity.y, -10.0f);
-    }
+	std::vector< Rect > &rects = static_rects;
+	rects.clear();
+	rects.reserve(star_layer.size() + shadow2_layer.size() + shadow_layer.size() + map_layer.size());
 
-    // apply instantaneous jerk if jumping or B.O.U.N.C. jumping
-    if (do_jump) {
-        player_velocity.y = jump_velocity;
-    }
-    if (do_bounce_jump) {
-        player_velocity.y = bounce_velocity;
-    }
+	// our hero is too edgy to *cast* a shadow
 
-    player += elapsed * player_velocity;
-    do_jump = false;
-    do_bounce_jump = false;
+	// a level file's own stars (in front of the sky pass's)
+	for (const auto& star : star_layer) {
+		rects.emplace_back(star.position, star.radius, moon_core_color, 0.0f);
+	}
 
-    // reset the player to start if the player falls off the map
-    // This makes the game extra frustrating. Muhahahaha.
-	if (player.y < -20.0f) {
-        player = player_start;
-		deaths++;
-    }
+	// city back to front
+	for (const auto& shadow_box : shadow2_layer) {
+		rects.emplace_back(shadow_box.position, shadow_box.radius, shadow2_color, 0.1f);
+	}
 
-	// clamp player to sides
-	if (player.x >= 10.0f) {
-		player.x = 10.0f;
+	for (const auto& shadow_box : shadow_layer) {
+		rects.emplace_back(shadow_box.position, shadow_box.radius, shadow_color, 0.1f);
 	}
-	else if (player.x <= -10.0f) {
-		player.x = -10.0f;
+
+	// map
+	for (const auto& box : map_layer) {
+		rects.emplace_back(box.position, box.radius, fg_color, 0.1f);
 	}
 
-	//----- ball update -----
+	static_count = GLsizei(rects.size());
 
-	ball += elapsed * ball_velocity;
+	glBindBuffer(GL_ARRAY_BUFFER, static_rect_buffer);
+	glBufferData(GL_ARRAY_BUFFER, rects.size() * sizeof(rects[0]), rects.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	static_bytes += rects.size() * sizeof(rects[0]);
 
-	//---- collision handling ----
+	//other levels never upload again, so there's no need to hang on to the copy:
+	if (!sim.stream) std::vector< Rect >().swap(static_rects);
 
-    // player vs box
-    auto player_vs_box = [this](const Box& box) {
-        // compute area of overlap
-		glm::vec2 min = glm::max(player - player_radius, box.position - box.radius);
-		glm::vec2 max = glm::min(player + player_radius, box.position + box.radius);
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
 
-        if (min.x > max.x || min.y > max.y) {
-            return false;
-        }
-        else {
-            //if player is "above" box, set grounded and attach player to ground
-            //don't use edges because of inaccuracies
-            if ((box.position.y + box.radius.y) < player.y) {
-                player_state = PlayerState::GROUND;
-                player.y = box.position.y + box.radius.y + player_radius.y;
-                player_velocity.y = 0;
-            }
-            // side collision: glue player to box side because they're dead anyway
-            else {
-                if (player.x < box.position.x) {
-                    player.x = box.position.x - box.radius.x - player_radius.x;
-                }
-                else {
-                    player.x = box.position.x + box.radius.x + player_radius.x;
-                }
-            }
-
-            return true;
-        }
-    };
-	{
-		bool collided = false;
-		for (const auto& box : boxes) {
-			collided = collided || player_vs_box(box);
-		}
+bool BouncMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	bool handled = sim.handle_event(evt, window_size);
 
-		// if no collision happened and player was on the gound, player is in the air
-		if (!collided && player_state == PlayerState::GROUND) {
-			player_state = PlayerState::AIR;
-		}
+	if (evt.type == SDL_MOUSEBUTTONDOWN) {
+		//ball was just fired; don't interpolate it from wherever it was to the player:
+		prev_ball = sim.ball;
 	}
 
-	// compute ball-and-box collisions
-	// side effect: reflects ball
-    auto ball_vs_box = [this](const Box& box) {
-	    //compute area of overlap:
-		glm::vec2 min = glm::max(box.position - box.radius, ball - ball_radius);
-		glm::vec2 max = glm::min(box.position + box.radius, ball + ball_radius);
+	return handled;
+}
 
-		//if no overlap, no collision:
-		if (min.x > max.x || min.y > max.y) {
-            return false;
-        }
+void BouncMode::update(float elapsed) {
+	PROFILE_ZONE("BouncMode::update");
+	prev_player = sim.player;
+	prev_ball = sim.ball;
+	sim.update(elapsed);
+}
 
-		if (max.x - min.x > max.y - min.y) {
-			//wider overlap in x => bounce in y direction:
-			if (ball.y > box.position.y) {
-				ball.y = box.position.y + box.radius.y + ball_radius.y;
-				ball_velocity.y = std::abs(ball_velocity.y);
-			} else {
-				ball.y = box.position.y - box.radius.y - ball_radius.y;
-				ball_velocity.y = -std::abs(ball_velocity.y);
-			}
-		} else {
-			//wider overlap in y => bounce in x direction:
-			if (ball.x > box.position.x) {
-				ball.x = box.position.x + box.radius.x + ball_radius.x;
-				ball_velocity.x = std::abs(ball_velocity.x);
-			} else {
-				ball.x = box.position.x - box.radius.x - ball_radius.x;
-				ball_velocity.x = -std::abs(ball_velocity.x);
-			}
+void BouncMode::sync() {
+	drawing.player = sim.player;
+	drawing.prev_player = prev_player;
+	drawing.ball = sim.ball;
+	drawing.prev_ball = prev_ball;
+	drawing.player_velocity = sim.player_velocity;
+	drawing.deaths = sim.deaths;
+	drawing.exaggerated_frames = sim.exaggerated_frames;
+	drawing.has_ended = sim.has_ended;
+	drawing.hash = sim.state_hash();
+
+	//endless level: the boxes and scenery near the player change as they move
+	// (copied into vectors that keep their capacity, so this doesn't allocate once warmed up):
+	if (sim.stream && sim.stream->version != drawing.level_version) {
+		drawing.level_version = sim.stream->version;
+		drawing.boxes = sim.boxes;
+		shadow2_boxes.clear();
+		shadow_boxes.clear();
+		for (int32_t index = sim.stream->center - LevelStream::Near; index <= sim.stream->center + LevelStream::Near; ++index) {
+			LevelChunk const *chunk = sim.stream->chunk(index);
+			if (!chunk) continue;
+			shadow2_boxes.insert(shadow2_boxes.end(), chunk->shadow2_boxes.begin(), chunk->shadow2_boxes.end());
+			shadow_boxes.insert(shadow_boxes.end(), chunk->shadow_boxes.begin(), chunk->shadow_boxes.end());
 		}
-        return true;
-    };
+	}
+}
 
-    for (const auto& box : boxes) {
-        ball_vs_box(box);
-    }
+bool BouncMode::needs_redraw() const {
+	//nothing to draw until the first frame:
+	if (!drawn) return true;
+	//still moving, so the interpolated positions depend on alpha:
+	// (the ball never stops while the game is being played, so in practice this only goes idle once it has ended)
+	if (drawing.prev_player != drawing.player || drawing.prev_ball != drawing.ball) return true;
+	//something else (deaths, lean, game over) changed since the last draw:
+	return drawing.hash != drawn_hash;
+}
 
-	// also collision check with ground (unlike player who falls to their doom)
-    ball_vs_box(ground);
+void BouncMode::draw(glm::uvec2 const &drawable_size, float alpha) {
+	PROFILE_ZONE("BouncMode::draw");
 
-    // compute player-and-ball collision
-	// side effect: can trigger B.O.U.N.C. jumps if this is the
-	// first time that the ball is hitting the player
-	//compute area of overlap:
-    glm::vec2 min = glm::max(player - player_radius, ball - ball_radius);
-    glm::vec2 max = glm::min(player + player_radius, ball + ball_radius);
+	if (rect_stream_for_rect_program == 0) create_vertex_array();
 
-    //if no overlap, no collision:
-    if (min.x > max.x || min.y > max.y) {
+	//last frame's containers are done with:
+	frame_arena.reset();
 
-    }
-    else {
-        if (ball_state == BallState::CAN_HIT) {
-            do_bounce_jump = true;
-            ball_state = BallState::FREE;
-        }
-    }
-}
+	//endless levels: the scenery and boxes around the player changed (sync() copied the new ones), so re-upload them:
+	if (sim.stream && static_level_version != drawing.level_version) upload_static_geometry();
 
-void BouncMode::draw(glm::uvec2 const &drawable_size) {
-	//some nice colors from the course web page:
-	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
-	// made bg_color a tad darker for night feel
-	const glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x102538ff);
-	const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xf2d2b6ff);
-	// made this a bit darker for backgorund buildings
-	const glm::u8vec4 shadow_color = HEX_TO_U8VEC4(0x6b3d32ff);
-	// even darker variant of above
-    const glm::u8vec4 shadow2_color = HEX_TO_U8VEC4(0x291713ff);
-	// for rim of moon image
-    const glm::u8vec4 moon_outline_color = HEX_TO_U8VEC4(0x347cbaff);
-	// for moon and stars
-    const glm::u8vec4 moon_core_color = HEX_TO_U8VEC4(0xffe7e3ff);
-	// for player
-	const glm::u8vec4 player_color = HEX_TO_U8VEC4(0xb3391bff);
-	// for ball
-	const glm::u8vec4 ball_color = HEX_TO_U8VEC4(0xff8161ff);
-	#undef HEX_TO_U8VEC4
+	drawn_hash = drawing.hash;
+	drawn = true;
 
 	//other useful drawing constants:
 	const float wall_radius = 0.05f;
-	const float padding = 0.14f; //padding between outside of walls and edge of window
 
-	//---- compute vertices to draw ----
+	//---- compute rectangles to draw ----
+	// (the scenery and map are already in static_rect_buffer; these are the things that move)
 
-	//vertices will be accumulated into this list and then uploaded+drawn at the end of this function:
-	std::vector< Vertex > vertices;
+	//rectangles will be written straight into rect_stream's mapped memory, then drawn at the end of this function:
+	// (room for the player, ball, death counter, and the end screen's binary digits, at most two rectangles per bit)
+	const size_t max_rects = 2 + drawing.deaths + (drawing.has_ended ? 2 * 32 : 0);
+	Rect *rects = rect_stream.map< Rect >(max_rects);
+	size_t rect_count = 0;
 
 	//inline helper function for rectangle drawing:
 	// extra param: "lean" displaces two vertices to make the rectangle deform to point left or right
-	// also used to make the buildings slightly asymmetrical for extra edginess
-	auto draw_rectangle = [&vertices](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color, float lean) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x + (lean > 0 ? lean : 0), center.y+radius.y + (lean > 0 ? lean : 0), 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x + (lean > 0 ? lean : 0), center.y+radius.y + (lean > 0 ? lean : 0), 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x-radius.x + (lean < 0 ? lean : 0), center.y+radius.y + (lean < 0 ? -lean :0), 0.0f), color, glm::vec2(0.5f, 0.5f));
+	// (rect_program does the deforming; see InstancedRectProgram::Rect)
+	auto draw_rectangle = [rects, &rect_count, max_rects](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color, float lean) {
+		assert(rect_count < max_rects);
+		new (rects + rect_count) Rect(center, radius, color, lean);
+		rect_count += 1;
 	};
 
-	// our hero is too edgy to *cast* a shadow
-
-	// draw night sky
-	// this should probably be done faster in the shader
-    for (const auto& star : stars) {
-        draw_rectangle(star.position, star.radius, moon_core_color, 0);    
-    }
-
-    draw_rectangle(moon_outline.position, moon_outline.radius, moon_outline_color, 0);
-    draw_rectangle(moon_core.position, moon_core.radius, moon_core_color, 0);
+	//inline helper function for interpolating between the previous and current update:
+	// (large jumps are respawns, so those snap instead of sliding across the screen)
+	auto interpolate = [alpha](glm::vec2 const &prev, glm::vec2 const &cur) {
+		if (glm::length(cur - prev) > 2.0f) return cur;
+		return glm::mix(prev, cur, alpha);
+	};
 
-	// draw city back to front
-    for (const auto& shadow_box : shadow2_boxes) {
-        draw_rectangle(shadow_box.position, shadow_box.radius, shadow2_color, 0.1f);
-    }
-    
-    for (const auto& shadow_box : shadow_boxes) {
-        draw_rectangle(shadow_box.position, shadow_box.radius, shadow_color, 0.1f);
-    }
-    
-	// draw map
-    for (const auto& box : boxes) {
-        draw_rectangle(box.position, box.radius, fg_color, 0.1f);
-    }
+	//endless levels scroll to keep the player in the middle; the original court doesn't move:
+	const float view_x = (sim.stream ? interpolate(drawing.prev_player, drawing.player).x : 0.0f);
+	const glm::vec2 view_offset = glm::vec2(view_x, 0.0f);
 
 	// draw ground for debug purposes
     //draw_rectangle(ground.position, ground.radius, fg_color, 0);
@@ -434,40 +302,39 @@ void BouncMode::draw(glm::uvec2 const &drawable_size) {
 		// check if player is leaning left or right based on direction of motion
 		// lean away, as if being blow back by the wind
 		float player_lean = 0.0f;
-		if (player_velocity.x < 0) {
+		if (drawing.player_velocity.x < 0) {
 			player_lean = 0.05f;
 		}
-		else if (player_velocity.x > 0) {
+		else if (drawing.player_velocity.x > 0) {
 			player_lean = -0.05f;
 		}
 		
 		// hyperextended frames for that animation oomph when jumping
 		// interpolate linearly back to normal using frame count
-		// TODO: do this in a frame independent way
-		if (exaggerated_frames) {
-			float lean_factor = 1.0f - (exaggerated_frames * 0.4f) ;
+		// (counted down in BouncSim::update, so this is frame-rate independent)
+		if (drawing.exaggerated_frames) {
+			float lean_factor = 1.0f - (drawing.exaggerated_frames * 0.4f) ;
 			player_lean *= lean_factor;
-			exaggerated_frames--;
 		}
 
 		// render player
-		draw_rectangle(player, player_radius, player_color, player_lean);
+		draw_rectangle(interpolate(drawing.prev_player, drawing.player), sim.player_radius, player_color, player_lean);
 	}
 
 	// render B.O.U.N.C. projectile
-	draw_rectangle(ball, ball_radius, ball_color, 0);
+	draw_rectangle(interpolate(drawing.prev_ball, drawing.ball), sim.ball_radius, ball_color, 0);
 
 	// death count
 	glm::vec2 deaths_radius = glm::vec2(0.05f, 0.1f);
-	for (uint32_t i = 0; i < deaths; ++i) {
-		draw_rectangle(glm::vec2( -court_radius.x + (2.0f + 3.0f * i) * deaths_radius.x, court_radius.y + 2.0f * wall_radius + 2.0f * deaths_radius.y), deaths_radius, fg_color, 0);
+	for (uint32_t i = 0; i < drawing.deaths; ++i) {
+		draw_rectangle(view_offset + glm::vec2( -sim.court_radius.x + (2.0f + 3.0f * i) * deaths_radius.x, sim.court_radius.y + 2.0f * wall_radius + 2.0f * deaths_radius.y), deaths_radius, fg_color, 0);
 	}
 
 	// if game has ended, show deaths in binary
 	// because I didn't have time to do fonts
-	if (has_ended) {
-		std::vector<uint32_t> bits;
-		uint32_t d = deaths;
+	if (drawing.has_ended) {
+		FrameVector<uint32_t> bits(frame_arena);
+		uint32_t d = drawing.deaths;
 		do {
 			bits.push_back(d % 2);
 			d /= 2;
@@ -488,45 +355,10 @@ void BouncMode::draw(glm::uvec2 const &drawable_size) {
 	}
 
 	//------ compute court-to-window transform ------
-
-	//compute area that should be visible:
-	glm::vec2 scene_min = glm::vec2(
-		-court_radius.x - 2.0f * wall_radius - padding,
-		-court_radius.y - 2.0f * wall_radius - padding
-	);
-	glm::vec2 scene_max = glm::vec2(
-		court_radius.x + 2.0f * wall_radius + padding,
-		court_radius.y + 2.0f * wall_radius + 3.0f * deaths_radius.y + padding
-	);
-
-	//compute window aspect ratio:
-	float aspect = drawable_size.x / float(drawable_size.y);
-	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
-
-	//compute scale factor for court given that...
-	float scale = std::min(
-		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
-		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
-	);
-
-	glm::vec2 center = 0.5f * (scene_max + scene_min);
-
-	//build matrix that scales and translates appropriately:
-	glm::mat4 court_to_clip = glm::mat4(
-		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, scale, 0.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-		glm::vec4(-center.x * (scale / aspect), -center.y * scale, 0.0f, 1.0f)
-	);
-	//NOTE: glm matrices are specified in *Column-Major* order,
-	// so each line above is specifying a *column* of the matrix(!)
-
-	//also build the matrix that takes clip coordinates to court coordinates (used for mouse handling):
-	clip_to_court = glm::mat3x2(
-		glm::vec2(aspect / scale, 0.0f),
-		glm::vec2(0.0f, 1.0f / scale),
-		glm::vec2(center.x, center.y)
-	);
+	//(shared with headless input replay, so it lives in the simulation)
+	glm::mat4 court_to_clip;
+	glm::mat3x2 clip_to_court;
+	sim.court_transforms(drawable_size, &court_to_clip, &clip_to_court, view_x);
 
 	//---- actual drawing ----
 
@@ -540,35 +372,53 @@ void BouncMode::draw(glm::uvec2 const &drawable_size) {
 	//don't use the depth test:
 	glDisable(GL_DEPTH_TEST);
 
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program.program);
+	//done writing rectangles (they're already in rect_stream.buffer; this just notes where):
+	const size_t first_rect = rect_stream.unmap< Rect >(rect_count);
+	stream_bytes += rect_count * sizeof(Rect);
+	drawn_frames += 1;
+
+	//night sky first (behind everything else), computed per pixel by sky_program:
+	glUseProgram(sky_program.program);
+	glUniformMatrix3x2fv(sky_program.CLIP_TO_COURT_mat3x2, 1, GL_FALSE, glm::value_ptr(clip_to_court));
+	// one star per cell, so the cell size sets the density:
+	glUniform1f(sky_program.STAR_CELL_float, 1.0f / std::sqrt(star_density));
+	glUniform1f(sky_program.STAR_RADIUS_float, star_radius);
+	glUniform4fv(sky_program.STAR_COLOR_vec4, 1, glm::value_ptr(glm::vec4(moon_core_color) / 255.0f));
+	// the view scrolls, but the moon stays put:
+	glUniform2fv(sky_program.MOON_CENTER_vec2, 1, glm::value_ptr(moon_core.position + view_offset));
+	glUniform1f(sky_program.MOON_RADIUS_float, moon_outline.radius.x);
+	glUniform1f(sky_program.MOON_RIM_float, moon_outline.radius.x - moon_core.radius.x);
+	glUniform4fv(sky_program.MOON_COLOR_vec4, 1, glm::value_ptr(glm::vec4(moon_core_color) / 255.0f));
+	glUniform4fv(sky_program.MOON_RIM_COLOR_vec4, 1, glm::value_ptr(glm::vec4(moon_outline_color) / 255.0f));
+	glBindVertexArray(empty_vertex_array);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	//set rect_program as current program:
+	glUseProgram(rect_program.program);
 
 	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
+	glUniformMatrix4fv(rect_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
 
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	//draw the scenery and map, from static_rect_buffer:
+	// (each rectangle is one instance of six vertices)
+	glBindVertexArray(static_rect_buffer_for_rect_program);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_count);
 
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
+	//then the things that move, using the mapping rect_stream_for_rect_program to fetch this frame's rectangles:
+	glBindVertexArray(rect_stream_for_rect_program);
+	rect_program.bind_rects(rect_stream.buffer, first_rect);
 
 	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
-
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, GLsizei(rect_count));
 
 	//reset vertex array to none:
 	glBindVertexArray(0);
 
 	//reset current program to none:
 	glUseProgram(0);
+
+	//this frame's part of rect_stream can be reused once the GPU is done with the draws above:
+	rect_stream.end_frame();
 	
 
 	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
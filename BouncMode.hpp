@@ -1,10 +1,17 @@
-#include "ColorTextureProgram.hpp"
+#pragma once
+
+#include "InstancedRectProgram.hpp"
+#include "SkyProgram.hpp"
+#include "BouncSim.hpp"
+#include "FrameArena.hpp"
+#include "StreamBuffer.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
 
 #include <glm/glm.hpp>
 
+#include <string>
 #include <vector>
 #include <deque>
 
@@ -13,82 +20,67 @@
  */
 
 struct BouncMode : Mode {
-	BouncMode();
+	//'endless' plays on an endless, streamed level instead of the original court (see LevelStream.hpp);
+	// a non-empty 'level' plays on that level file instead (see LevelFile.hpp):
+	//NOTE: constructor will throw if 'level' can't be loaded
+	explicit BouncMode(bool endless = false, std::string const &level = "");
 	virtual ~BouncMode();
 
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
-	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual void sync() override;
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) override;
+	virtual bool needs_redraw() const override;
 
 	//----- game state -----
-	// game configuration
-	const float velocity_scale = 4.0f;
-	const float jump_velocity = 5.0f;
-	const float bounce_velocity = 7.0f; // turn this down to <= 7.0f to make it extra frustrating!
-	const glm::vec2 gravity = glm::vec2(0.0f, -13.0f);
-	const glm::vec2 player_start = glm::vec2(-10.0f, 3.0f);
-
-	// AIR: player is in air, can be affected by gravity
-	// GROUND: player is on the ground, can't be affected by gravity
-	enum class PlayerState {
-		AIR,
-		GROUND
-	};
-
-	// CAN_HIT: ball can hit player for a B.O.U.N.C. jump
-	// FREE: ball will not collide with player
-	enum class BallState {
-		CAN_HIT,
-		FREE
-	};
-
-	// convenience struct for map boxes and collision
-	struct Box {
-		Box(const glm::vec2& position_, const glm::vec2& radius_) :
-			position(position_), radius(radius_) {}
-		glm::vec2 position;
-		glm::vec2 radius;
-	};
-
-	// randomly generated map geometry
-	std::vector<Box> boxes;
+	//simulation state (player, ball, map boxes) lives in BouncSim so it can also be run headlessly:
+	// (written by handle_event() and update(); the map boxes and sizes never change after construction,
+	//  so draw() reads those directly)
+	BouncSim sim;
+
+	//positions as of the previous update, for interpolating in draw():
+	glm::vec2 prev_player = sim.player;
+	glm::vec2 prev_ball = sim.ball;
+
+	//----- drawing state -----
+	//the parts of the simulation that change, as copied by sync(); the only game state draw() reads:
+	struct DrawState {
+		glm::vec2 player = glm::vec2(0.0f);
+		glm::vec2 prev_player = glm::vec2(0.0f);
+		glm::vec2 ball = glm::vec2(0.0f);
+		glm::vec2 prev_ball = glm::vec2(0.0f);
+		glm::vec2 player_velocity = glm::vec2(0.0f);
+		uint32_t deaths = 0;
+		uint32_t exaggerated_frames = 0;
+		bool has_ended = false;
+		uint64_t hash = 0; //sim.state_hash()
+		//endless levels only: the boxes near the player (copied when sim.stream->version changes)
+		std::vector<BouncSim::Box> boxes;
+		uint64_t level_version = 0;
+	} drawing;
+
+	//drawing.hash as of the last draw(), for needs_redraw():
+	uint64_t drawn_hash = 0;
+	bool drawn = false;
+
+	//shorthand for BouncSim::Box, used for scenery:
+	typedef BouncSim::Box Box;
+
+	// randomly generated background scenery
+	// (on endless levels, refilled by sync() from the chunks around the player;
+	//  levels loaded from a file leave these empty and draw the file's layers in place)
 	std::vector<Box> shadow_boxes;
 	std::vector<Box> shadow2_boxes;
-	std::vector<Box> stars;
 
-	// terrible night sky
+	// less terrible night sky, drawn per pixel by sky_program:
+	// (levels loaded from a file also draw the file's own stars, as rectangles)
+	// stars per square unit of court (the sky costs the same however many there are):
+	float star_density = 0.25f;
+	const float star_radius = 0.03f;
+	// the moon is a disc, with an outline; it stays put as endless levels scroll
 	const Box moon_outline = Box(glm::vec2(-6.0f, 3.0f), glm::vec2(0.35f, 0.35f));
 	const Box moon_core = Box(glm::vec2(-6.0f, 3.0f), glm::vec2(0.3f, 0.3f));
-	const Box ground = Box(glm::vec2(0.0f, -7.0f), glm::vec2(10.0f, 1.0f));
-
-	// state variables for player and ball
-	BallState ball_state = BallState::CAN_HIT;
-	PlayerState player_state = PlayerState::AIR;
-
-	// is there a pending jump or B.O.U.N.C. jump?
-	bool do_jump = false;
-	bool do_bounce_jump = false;
-
-	// has the game ended?
-	bool has_ended = false;
-
-	// player and area parameters
-	glm::vec2 court_radius = glm::vec2(10.0f, 5.0f);
-	glm::vec2 player_radius = glm::vec2(0.2f, 0.2f);
-	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
-
-	glm::vec2 player = player_start;
-	glm::vec2 player_velocity = glm::vec2(0.0f, 0.0f);
-
-	// spawn ball off screen
-	glm::vec2 ball = glm::vec2(0.0f, 30.0f);
-	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
-
-	uint32_t deaths = 0;
-
-	// frame counter for animation oomph
-	uint32_t exaggerated_frames = 0;
 
 	// "font library"
 	const glm::vec2 one_radius = glm::vec2(0.1f, 0.3f);
@@ -97,31 +89,43 @@ struct BouncMode : Mode {
 
 	//----- opengl assets / helpers ------
 
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
-	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "BouncMode::Vertex should be packed");
-
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
-
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
-
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
-
-	//Solid white texture:
-	GLuint white_tex = 0;
-
-	//matrix that maps from clip coordinates to court-space coordinates:
-	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
-	// (stored here so that the mouse handling code can use it to position the paddle)
-
+	//draw functions will work on vectors of rectangles, each drawn as one instance by rect_program:
+	typedef InstancedRectProgram::Rect Rect;
+
+	//storage for draw()'s per-frame containers (reset at the start of each draw):
+	FrameArena frame_arena;
+
+	//Shader program that draws transformed rectangles, one instance each:
+	InstancedRectProgram rect_program;
+
+	//Ring buffer that draw() writes each frame's rectangles into:
+	// (only what moves: the player, ball, death counter, and end screen)
+	StreamBuffer rect_stream;
+
+	//Buffer holding the scenery and map boxes, which only change with the level:
+	// (uploaded once, as GL_STATIC_DRAW, by upload_static_geometry(); on endless levels, again whenever drawing.level_version changes)
+	GLuint static_rect_buffer = 0;
+	void upload_static_geometry();
+	//(endless levels re-upload as the player moves, so they keep the rectangle list's capacity around between uploads)
+	std::vector< Rect > static_rects;
+	uint64_t static_level_version = 0;
+	//static_rect_buffer is drawn in order: a level file's stars, then buildings and map boxes:
+	GLsizei static_count = 0;
+
+	//Vertex Array Objects that map buffer locations to rect_program attribute locations:
+	// (created by create_vertex_array() on first draw)
+	// (rect_stream's is pointed at each frame's rectangles as they are drawn)
+	GLuint rect_stream_for_rect_program = 0;
+	GLuint static_rect_buffer_for_rect_program = 0;
+	void create_vertex_array();
+
+	//Shader program that draws the stars and moon, filling the screen:
+	SkyProgram sky_program;
+	//(sky_program makes its one triangle from gl_VertexID, but drawing still needs a vertex array object bound)
+	GLuint empty_vertex_array = 0;
+
+	//bytes uploaded to rect buffers, reported when the mode is destroyed:
+	uint64_t stream_bytes = 0; //(rect_stream, over all frames)
+	uint64_t static_bytes = 0; //(static_rect_buffer, over all uploads)
+	uint64_t drawn_frames = 0;
 };
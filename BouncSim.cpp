@@ -0,0 +1,495 @@
+#include "BouncSim.hpp"
+
+#include "LevelFile.hpp"
+#include "LevelStream.hpp"
+#include "hash_fnv1a.hpp"
+#include "swept_aabb.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BouncSim::BouncSim() {
+    player = player_start;
+
+    court_boxes(&boxes);
+
+    build_collision();
+}
+
+void BouncSim::court_boxes(std::vector<Box> *boxes) {
+    // construct the map - this could (should) be done via asset pipeline
+    boxes->emplace_back(glm::vec2(-10.0f, -3.0f), glm::vec2(0.6f, 3.0f));
+    boxes->emplace_back(glm::vec2(-6.0f, -3.0f), glm::vec2(0.6f, 3.0f));
+    boxes->emplace_back(glm::vec2(-1.0f, -3.0f), glm::vec2(0.6f, 3.0f));
+    boxes->emplace_back(glm::vec2(3.0f, -2.0f), glm::vec2(0.6f, 4.0f));
+    boxes->emplace_back(glm::vec2(7.0f, -4.0f), glm::vec2(0.6f, 2.0f));
+    boxes->emplace_back(glm::vec2(10.0f, -4.0f), glm::vec2(0.6f, 2.0f));
+}
+
+void BouncSim::use_level_file(std::shared_ptr<LevelFile const> const &file) {
+    // nothing is copied or built: the file's arrays are used where they are
+    level_file = file;
+    boxes.clear();
+    ground = file->ground();
+    file->use_collision(&box_grid, &box_soa);
+}
+
+ArrayView<BouncSim::Box> BouncSim::map_boxes() const {
+	return (level_file ? level_file->boxes() : ArrayView<Box>(boxes));
+}
+
+void BouncSim::enable_streaming(uint64_t seed) {
+    stream = std::make_shared<LevelStream>(seed);
+    stream->update(player.x);
+    stream->near_boxes(&boxes);
+    build_collision();
+    view_x = player.x;
+}
+
+void BouncSim::build_collision() {
+	level_file.reset();
+	box_grid.build(boxes);
+	box_soa.build(boxes);
+}
+
+// index of the lowest set bit of a (non-zero) BoxSoA::overlap_mask result:
+static inline uint32_t lowest_bit(uint32_t mask) {
+	uint32_t i = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		i += 1;
+	}
+	return i;
+}
+
+bool BouncSim::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	if (evt.type == SDL_KEYDOWN) {
+		key_down(evt.key.keysym.sym);
+	}
+
+	else if (evt.type == SDL_KEYUP) {
+		key_up(evt.key.keysym.sym);
+	}
+
+	// on mouse click, fire the B.O.U.N.C. projectile (ball)
+	else if (evt.type == SDL_MOUSEBUTTONDOWN) {
+		glm::vec2 clip_mouse = glm::vec2(
+			(evt.button.x + 0.5f) / window_size.x * 2.0f - 1.0f,
+			(evt.button.y + 0.5f) / window_size.y *-2.0f + 1.0f
+		);
+		glm::mat4 court_to_clip;
+		glm::mat3x2 clip_to_court;
+		court_transforms(window_size, &court_to_clip, &clip_to_court, view_x);
+		fire(clip_to_court * glm::vec3(clip_mouse, 1.0f));
+	}
+
+	return false;
+}
+
+void BouncSim::key_down(SDL_Keycode key) {
+    // set player velocity, and if space, start jumping
+    switch(key) {
+        case SDLK_w:
+            player_velocity.y = velocity_scale;
+            break;
+        case SDLK_s:
+            player_velocity.y = -velocity_scale;
+            break;
+        case SDLK_a:
+            player_velocity.x = -velocity_scale;
+            break;
+        case SDLK_d:
+            player_velocity.x = velocity_scale;
+            break;
+        case SDLK_SPACE:
+            if (player_state == PlayerState::GROUND) {
+                do_jump = true;
+                player_state = PlayerState::AIR;
+                // hyperextended frame time for animation oomph
+                exaggerated_frames = 10;
+            }
+            break;
+    }
+}
+
+void BouncSim::key_up(SDL_Keycode key) {
+    // stop moving
+    switch(key) {
+        case SDLK_w:
+        case SDLK_s:
+            player_velocity.y = 0.0f;
+            break;
+        case SDLK_a:
+        case SDLK_d:
+            player_velocity.x = 0.0f;
+            break;
+    }
+}
+
+void BouncSim::fire(glm::vec2 const &target) {
+    // shoot the ball from the player
+    ball = player;
+    ball_velocity = glm::normalize(target - ball) * ball_speed;
+	// pre-shift the ball a bit so that the player can't cheese by firing upwards
+	ball += ball_pre_shift * ball_velocity;
+    // ball starts being able to hit the player to cause a B.O.U.N.C. jump
+    ball_state = BallState::CAN_HIT;
+}
+
+void BouncSim::update(float elapsed) {
+	// check if the game was won
+	// game is won if player is grounded and touching the right edge
+	// (endless levels have no right edge)
+	if (!stream && player_state == PlayerState::GROUND && (player.x + player_radius.x >= 10.0f)) {
+		has_ended = true;
+	}
+
+	// do no updates if game has ended
+	if (has_ended) return;
+
+	// count down hyperextended frames (one per tick)
+	if (exaggerated_frames) {
+		exaggerated_frames--;
+	}
+
+    // ----player state update----
+    // only apply gravity when in the air
+	if (player_state == PlayerState::AIR) {
+        player_velocity += elapsed * gravity;
+        player_velocity.y = std::max(player_velocity.y, -10.0f);
+    }
+
+    // apply instantaneous jerk if jumping or B.O.U.N.C. jumping
+    if (do_jump) {
+        player_velocity.y = jump_velocity;
+    }
+    if (do_bounce_jump) {
+        player_velocity.y = bounce_velocity;
+    }
+
+    player += elapsed * player_velocity;
+    do_jump = false;
+    do_bounce_jump = false;
+
+    // reset the player to start if the player falls off the map
+    // This makes the game extra frustrating. Muhahahaha.
+	if (player.y < -20.0f) {
+        player = player_start;
+		deaths++;
+    }
+
+	// clamp player to sides
+	if (stream) {
+		// (endless level: bring in the chunks around the player, and keep the ground under the ball)
+		if (stream->update(player.x)) {
+			stream->near_boxes(&boxes);
+			build_collision();
+		}
+		ground.position.x = ball.x;
+		view_x = player.x;
+	}
+	else if (player.x >= 10.0f) {
+		player.x = 10.0f;
+	}
+	else if (player.x <= -10.0f) {
+		player.x = -10.0f;
+	}
+
+	//----- ball update -----
+
+	// which path to take this tick:
+	Collision path = collision_path();
+
+	// move the ball, bouncing off any boxes it hits on the way:
+	move_ball(&ball, &ball_velocity, elapsed, path, &candidates);
+
+	//---- collision handling ----
+
+    // player vs box
+    auto player_vs_box = [this](const Box& box) {
+        // compute area of overlap
+		glm::vec2 min = glm::max(player - player_radius, box.position - box.radius);
+		glm::vec2 max = glm::min(player + player_radius, box.position + box.radius);
+
+        if (min.x > max.x || min.y > max.y) {
+            return false;
+        }
+        else {
+            //if player is "above" box, set grounded and attach player to ground
+            //don't use edges because of inaccuracies
+            if ((box.position.y + box.radius.y) < player.y) {
+                player_state = PlayerState::GROUND;
+                player.y = box.position.y + box.radius.y + player_radius.y;
+                player_velocity.y = 0;
+            }
+            // side collision: glue player to box side because they're dead anyway
+            else {
+                if (player.x < box.position.x) {
+                    player.x = box.position.x - box.radius.x - player_radius.x;
+                }
+                else {
+                    player.x = box.position.x + box.radius.x + player_radius.x;
+                }
+            }
+
+            return true;
+        }
+    };
+	{
+		ArrayView<Box> const level = map_boxes();
+		bool collided = false;
+		if (path == Collision::Grid) {
+			// only the first box hit (in index order) counts, as in the scan below:
+			box_grid.query(player - player_radius, player + player_radius, &candidates);
+			for (uint32_t i : candidates) {
+				if (player_vs_box(level[i])) {
+					collided = true;
+					break;
+				}
+			}
+		} else if (path == Collision::Simd) {
+			// only the first overlapping box needs resolving:
+			for (uint32_t first = 0; first < box_soa.count; first += BoxSoA::Lanes) {
+				uint32_t mask = box_soa.overlap_mask(first, player - player_radius, player + player_radius);
+				if (mask) {
+					collided = player_vs_box(level[first + lowest_bit(mask)]);
+					break;
+				}
+			}
+		} else {
+			for (const auto& box : level) {
+				collided = collided || player_vs_box(box);
+			}
+		}
+
+		// if no collision happened and player was on the gound, player is in the air
+		if (!collided && player_state == PlayerState::GROUND) {
+			player_state = PlayerState::AIR;
+		}
+	}
+
+
+    // compute player-and-ball collision
+	// side effect: can trigger B.O.U.N.C. jumps if this is the
+	// first time that the ball is hitting the player
+	//compute area of overlap:
+    glm::vec2 min = glm::max(player - player_radius, ball - ball_radius);
+    glm::vec2 max = glm::min(player + player_radius, ball + ball_radius);
+
+    //if no overlap, no collision:
+    if (min.x > max.x || min.y > max.y) {
+
+    }
+    else {
+        if (ball_state == BallState::CAN_HIT) {
+            do_bounce_jump = true;
+            ball_state = BallState::FREE;
+        }
+    }
+}
+
+BouncSim::Collision BouncSim::collision_path() const {
+	if (collision == Collision::Grid && map_boxes().size() < BroadphaseMinBoxes) return Collision::Simd;
+	return collision;
+}
+
+void BouncSim::move_ball(glm::vec2 *ball, glm::vec2 *velocity, float elapsed, Collision path, std::vector< uint32_t > *candidates) const {
+	sweep_ball(ball, velocity, elapsed, path, candidates);
+
+	ArrayView<Box> const level = map_boxes();
+
+	// compute ball-and-box collisions
+	// (catches boxes the ball already overlapped at the start of the sweep)
+	// side effect: reflects ball
+    auto ball_vs_box = [&](const Box& box) {
+	    //compute area of overlap:
+		glm::vec2 min = glm::max(box.position - box.radius, *ball - ball_radius);
+		glm::vec2 max = glm::min(box.position + box.radius, *ball + ball_radius);
+
+		//if no overlap, no collision:
+		if (min.x > max.x || min.y > max.y) {
+            return false;
+        }
+
+		//wider overlap in x => bounce in y direction:
+		bounce_ball(box, max.x - min.x > max.y - min.y, ball, velocity);
+        return true;
+    };
+
+	if (path == Collision::Grid) {
+		// every bounce moves the ball, so find candidates again after one,
+		// continuing with the boxes after the one hit (as the scan below would):
+		box_grid.query(*ball - ball_radius, *ball + ball_radius, candidates);
+		size_t c = 0;
+		while (c < candidates->size()) {
+			uint32_t i = (*candidates)[c];
+			if (ball_vs_box(level[i])) {
+				box_grid.query(*ball - ball_radius, *ball + ball_radius, candidates);
+				c = std::upper_bound(candidates->begin(), candidates->end(), i) - candidates->begin();
+			} else {
+				c += 1;
+			}
+		}
+	} else if (path == Collision::Simd) {
+		// resolve overlaps one at a time, since each bounce moves the ball,
+		// testing again from the box after the one hit:
+		uint32_t first = 0;
+		while (first < box_soa.count) {
+			uint32_t mask = box_soa.overlap_mask(first, *ball - ball_radius, *ball + ball_radius);
+			if (mask) {
+				uint32_t i = first + lowest_bit(mask);
+				ball_vs_box(level[i]);
+				first = i + 1;
+			} else {
+				first += BoxSoA::Lanes;
+			}
+		}
+	} else {
+		for (const auto& box : level) {
+			ball_vs_box(box);
+		}
+	}
+
+	// also collision check with ground (unlike player who falls to their doom)
+    ball_vs_box(ground);
+}
+
+void BouncSim::bounce_ball(Box const &box, bool vertical, glm::vec2 *ball, glm::vec2 *velocity) const {
+	if (vertical) {
+		if (ball->y > box.position.y) {
+			ball->y = box.position.y + box.radius.y + ball_radius.y;
+			velocity->y = std::abs(velocity->y);
+		} else {
+			ball->y = box.position.y - box.radius.y - ball_radius.y;
+			velocity->y = -std::abs(velocity->y);
+		}
+	} else {
+		if (ball->x > box.position.x) {
+			ball->x = box.position.x + box.radius.x + ball_radius.x;
+			velocity->x = std::abs(velocity->x);
+		} else {
+			ball->x = box.position.x - box.radius.x - ball_radius.x;
+			velocity->x = -std::abs(velocity->x);
+		}
+	}
+}
+
+void BouncSim::sweep_ball(glm::vec2 *ball, glm::vec2 *velocity, float elapsed, Collision path, std::vector< uint32_t > *candidates) const {
+	ArrayView<Box> const level = map_boxes();
+	float remaining = elapsed;
+	for (uint32_t bounce = 0; bounce < MaxBallBounces; ++bounce) {
+		glm::vec2 step = remaining * *velocity;
+
+		// earliest box hit during the rest of the step
+		// (ties go to the lowest index, then the ground, so every path agrees):
+		float hit_t = remaining;
+		int hit_axis = 0;
+		Box const *hit = nullptr;
+		auto test = [&](Box const &box) {
+			float t;
+			int axis;
+			if (swept_aabb(*ball, ball_radius, *velocity, box.position - box.radius, box.position + box.radius, hit_t, &t, &axis)
+			 && (hit == nullptr || t < hit_t)) {
+				hit_t = t;
+				hit_axis = axis;
+				hit = &box;
+			}
+		};
+
+		// boxes the ball could touch are those overlapping the whole swept area:
+		glm::vec2 sweep_min = glm::min(*ball, *ball + step) - ball_radius;
+		glm::vec2 sweep_max = glm::max(*ball, *ball + step) + ball_radius;
+		if (path == Collision::Grid) {
+			box_grid.query(sweep_min, sweep_max, candidates);
+			for (uint32_t i : *candidates) {
+				test(level[i]);
+			}
+		} else if (path == Collision::Simd) {
+			for (uint32_t first = 0; first < box_soa.count; first += BoxSoA::Lanes) {
+				uint32_t mask = box_soa.overlap_mask(first, sweep_min, sweep_max);
+				while (mask) {
+					uint32_t bit = lowest_bit(mask);
+					test(level[first + bit]);
+					mask &= ~(1u << bit);
+				}
+			}
+		} else {
+			for (const auto& box : level) {
+				test(box);
+			}
+		}
+		test(ground);
+
+		if (hit == nullptr) {
+			*ball += step;
+			return;
+		}
+
+		// move to the point of contact and reflect off the face hit:
+		*ball += hit_t * *velocity;
+		bounce_ball(*hit, hit_axis == 1, ball, velocity);
+		remaining -= hit_t;
+	}
+	// out of bounces (ball wedged somewhere); just drop the rest of the step
+}
+
+void BouncSim::court_transforms(glm::uvec2 const &drawable_size, glm::mat4 *court_to_clip, glm::mat3x2 *clip_to_court, float view_x) const {
+	//layout of the frame around the court (must match BouncMode::draw):
+	const float wall_radius = 0.05f;
+	const float padding = 0.14f; //padding between outside of walls and edge of window
+	const glm::vec2 deaths_radius = glm::vec2(0.05f, 0.1f);
+
+	//compute area that should be visible:
+	glm::vec2 scene_min = glm::vec2(
+		-court_radius.x - 2.0f * wall_radius - padding,
+		-court_radius.y - 2.0f * wall_radius - padding
+	);
+	glm::vec2 scene_max = glm::vec2(
+		court_radius.x + 2.0f * wall_radius + padding,
+		court_radius.y + 2.0f * wall_radius + 3.0f * deaths_radius.y + padding
+	);
+
+	//compute window aspect ratio:
+	float aspect = drawable_size.x / float(drawable_size.y);
+	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
+
+	//compute scale factor for court given that...
+	float scale = std::min(
+		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
+		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
+	);
+
+	glm::vec2 center = 0.5f * (scene_max + scene_min);
+	center.x += view_x;
+
+	//build matrix that scales and translates appropriately:
+	*court_to_clip = glm::mat4(
+		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, scale, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-center.x * (scale / aspect), -center.y * scale, 0.0f, 1.0f)
+	);
+	//NOTE: glm matrices are specified in *Column-Major* order,
+	// so each line above is specifying a *column* of the matrix(!)
+
+	//also build the matrix that takes clip coordinates to court coordinates (used for mouse handling):
+	*clip_to_court = glm::mat3x2(
+		glm::vec2(aspect / scale, 0.0f),
+		glm::vec2(0.0f, 1.0f / scale),
+		glm::vec2(center.x, center.y)
+	);
+}
+
+uint64_t BouncSim::state_hash() const {
+	uint64_t hash = FNV1A_OFFSET;
+	hash = fnv1a(hash, player);
+	hash = fnv1a(hash, player_velocity);
+	hash = fnv1a(hash, ball);
+	hash = fnv1a(hash, ball_velocity);
+	hash = fnv1a(hash, uint32_t(player_state));
+	hash = fnv1a(hash, uint32_t(ball_state));
+	hash = fnv1a(hash, uint32_t(do_jump) | uint32_t(do_bounce_jump) << 1 | uint32_t(has_ended) << 2);
+	hash = fnv1a(hash, deaths);
+	hash = fnv1a(hash, exaggerated_frames);
+	return hash;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "BoxGrid.hpp"
+#include "BoxSoA.hpp"
+#include "array_view.hpp"
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <cstdint>
+
+struct LevelStream;
+struct LevelFile;
+
+/*
+ * BouncState is everything about a game of B.O.U.N.C. that changes as it is played,
+ *  in one trivially-copyable block: copying it is a snapshot, and copying it back is a restore.
+ *  (The level, the game constants, and scratch space stay in BouncSim.)
+ */
+
+struct BouncState {
+	// AIR: player is in air, can be affected by gravity
+	// GROUND: player is on the ground, can't be affected by gravity
+	enum class PlayerState {
+		AIR,
+		GROUND
+	};
+
+	// CAN_HIT: ball can hit player for a B.O.U.N.C. jump
+	// FREE: ball will not collide with player
+	enum class BallState {
+		CAN_HIT,
+		FREE
+	};
+
+	// (BouncSim's constructor puts the player at player_start)
+	glm::vec2 player = glm::vec2(0.0f, 0.0f);
+	glm::vec2 player_velocity = glm::vec2(0.0f, 0.0f);
+
+	// spawn ball off screen
+	glm::vec2 ball = glm::vec2(0.0f, 30.0f);
+	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+
+	// state variables for player and ball
+	BallState ball_state = BallState::CAN_HIT;
+	PlayerState player_state = PlayerState::AIR;
+
+	uint32_t deaths = 0;
+
+	// tick counter for animation oomph
+	uint32_t exaggerated_frames = 0;
+
+	// where the view is centered on endless levels (the player's x):
+	float view_x = 0.0f;
+
+	// is there a pending jump or B.O.U.N.C. jump?
+	bool do_jump = false;
+	bool do_bounce_jump = false;
+
+	// has the game ended?
+	bool has_ended = false;
+};
+static_assert(std::is_trivially_copyable< BouncState >::value && std::is_standard_layout< BouncState >::value, "BouncState should be plain data");
+
+/*
+ * BouncSim holds the simulation state of a game of B.O.U.N.C.
+ *  It owns no OpenGL resources, so it can be stepped without a window
+ *  (see sim_bench.cpp) as well as by BouncMode.
+ * The state that changes during play is its BouncState base, so those members
+ *  read as before (sim.player, sim.ball, ...) and snapshot()/restore() are plain copies.
+ */
+
+struct BouncSim : BouncState {
+	BouncSim();
+
+	//input, called by BouncMode::handle_event (or directly by headless drivers):
+	// handle_event maps keyboard and mouse events onto the functions below
+	// (mouse positions are mapped to the court with court_transforms(window_size), which only depends on aspect ratio)
+	bool handle_event(SDL_Event const &evt, glm::uvec2 const &window_size);
+	void key_down(SDL_Keycode key);
+	void key_up(SDL_Keycode key);
+	//fire the B.O.U.N.C. projectile from the player toward 'target' (court coordinates):
+	void fire(glm::vec2 const &target);
+
+	//advance the simulation by 'elapsed' seconds:
+	void update(float elapsed);
+
+	//transforms between court coordinates and clip space for a 'drawable_size' framebuffer:
+	// (used by BouncMode::draw, and by handle_event to aim with the mouse)
+	// (view_x moves the view along the level, for endless levels)
+	void court_transforms(glm::uvec2 const &drawable_size, glm::mat4 *court_to_clip, glm::mat3x2 *clip_to_court, float view_x = 0.0f) const;
+
+	//hash of the dynamic simulation state (for checking that two runs ended up identical):
+	uint64_t state_hash() const;
+
+	//----- game state -----
+	// game configuration
+	const float velocity_scale = 4.0f;
+	const float jump_velocity = 5.0f;
+	const float bounce_velocity = 7.0f; // turn this down to <= 7.0f to make it extra frustrating!
+	const glm::vec2 gravity = glm::vec2(0.0f, -13.0f);
+	const glm::vec2 player_start = glm::vec2(-10.0f, 3.0f);
+	const float ball_speed = 15.0f;
+	// fired balls start a bit away from the player so that the player can't cheese by firing upwards:
+	const float ball_pre_shift = 0.03f;
+
+	// convenience struct for map boxes and collision
+	struct Box {
+		Box(const glm::vec2& position_, const glm::vec2& radius_) :
+			position(position_), radius(radius_) {}
+		glm::vec2 position;
+		glm::vec2 radius;
+	};
+
+	// map geometry the player and ball collide with
+	// (levels loaded from a LevelFile leave this empty and use the file's boxes; map_boxes() gives either)
+	std::vector<Box> boxes;
+	ArrayView<Box> map_boxes() const;
+	// (on endless levels, the ground follows the ball)
+	Box ground = Box(glm::vec2(0.0f, -7.0f), glm::vec2(10.0f, 1.0f));
+
+	// the original hand-made court's boxes:
+	static void court_boxes(std::vector<Box> *boxes);
+
+	// level from a LevelFile (see LevelFile.hpp): its boxes, ground, and prebuilt collision structures are used in place
+	// (the file stays mapped for as long as this, or any copy of this, uses it)
+	void use_level_file(std::shared_ptr<LevelFile const> const &file);
+	std::shared_ptr<LevelFile const> level_file;
+
+	// endless level, streamed in chunks around the player (see LevelStream.hpp):
+	// (replaces 'boxes' with the chunks near the player as they move; there is no right edge to win at)
+	void enable_streaming(uint64_t seed = DefaultStreamSeed);
+	static constexpr uint64_t DefaultStreamSeed = 0xb0bc;
+	std::shared_ptr<LevelStream> stream;
+
+	// acceleration structures built from boxes (call build_collision() after changing boxes; this also drops any level_file):
+	// broad-phase grid, so collision only looks at nearby boxes
+	BoxGrid box_grid;
+	// boxes as min/max arrays, for testing several boxes at once
+	BoxSoA box_soa;
+	void build_collision();
+
+	// how update() finds the boxes the player and ball hit (all give identical results):
+	// Grid: test candidates from box_grid (below BroadphaseMinBoxes boxes, uses Simd instead)
+	// Simd: test every box, several at a time, with BoxSoA::overlap_mask
+	// Scalar: test every box, one at a time (the original code; reference for benchmarks)
+	enum class Collision { Grid, Simd, Scalar };
+	Collision collision = Collision::Grid;
+	// below this many boxes, testing every box is faster than querying the grid
+	static constexpr uint32_t BroadphaseMinBoxes = 32;
+	// candidate list scratch space (kept so update() doesn't allocate)
+	std::vector<uint32_t> candidates;
+
+	// the path update() actually takes (Grid falls back to Simd on small levels):
+	Collision collision_path() const;
+
+	// move a ball-sized projectile at 'ball' for 'elapsed' seconds, bouncing off boxes and the ground
+	// (used for the B.O.U.N.C. ball and by ProjectilePool; it only reads the sim, so several threads
+	//  can move balls at once, each with its own 'candidates' scratch list):
+	void move_ball(glm::vec2 *ball, glm::vec2 *velocity, float elapsed, Collision path, std::vector< uint32_t > *candidates) const;
+	// balls move with swept (continuous) collision, so they can't tunnel through boxes
+	// however long the step; this many bounces are handled per step:
+	static constexpr uint32_t MaxBallBounces = 8;
+	void sweep_ball(glm::vec2 *ball, glm::vec2 *velocity, float elapsed, Collision path, std::vector< uint32_t > *candidates) const;
+	// reflect a ball off the top/bottom (vertical) or a side of a box, moving it to that face:
+	void bounce_ball(Box const &box, bool vertical, glm::vec2 *ball, glm::vec2 *velocity) const;
+
+	// player and area parameters
+	glm::vec2 court_radius = glm::vec2(10.0f, 5.0f);
+	glm::vec2 player_radius = glm::vec2(0.2f, 0.2f);
+	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+
+	// save / load the whole game state (see BouncState above; SnapshotRing.hpp keeps one per tick):
+	BouncState snapshot() const { return *this; }
+	void restore(BouncState const &state) { static_cast<BouncState &>(*this) = state; }
+};
@@ -0,0 +1,138 @@
+#include "BoxGrid.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+glm::ivec2 BoxGrid::cell_of(glm::vec2 const &at) const {
+	//(clamped to the grid; callers check for rectangles entirely outside it first)
+	glm::vec2 rel = (at - origin) / cell_size;
+	return glm::ivec2(
+		std::min(std::max(int32_t(std::floor(rel.x)), 0), int32_t(cells.x) - 1),
+		std::min(std::max(int32_t(std::floor(rel.y)), 0), int32_t(cells.y) - 1)
+	);
+}
+
+void BoxGrid::build_from_bounds(std::vector< glm::vec2 > const &mins, std::vector< glm::vec2 > const &maxs, float cell_size_) {
+	assert(mins.size() == maxs.size());
+	box_count = uint32_t(mins.size());
+	prebuilt = Arrays();
+	prebuilt_owner.reset();
+	cell_start.clear();
+	cell_items.clear();
+	large_items.clear();
+	cells = glm::uvec2(0);
+	if (box_count == 0) return;
+
+	//bounds of everything:
+	glm::vec2 lo = mins[0];
+	glm::vec2 hi = maxs[0];
+	glm::vec2 total_size = glm::vec2(0.0f);
+	for (uint32_t i = 0; i < box_count; ++i) {
+		lo = glm::min(lo, mins[i]);
+		hi = glm::max(hi, maxs[i]);
+		total_size += maxs[i] - mins[i];
+	}
+	glm::vec2 extent = glm::max(hi - lo, glm::vec2(1e-3f));
+
+	//pick a cell size about twice the average box size, but don't let the grid get much bigger than the box count:
+	if (!(cell_size_ > 0.0f)) {
+		glm::vec2 average = total_size / float(box_count);
+		cell_size_ = std::max(2.0f * std::max(average.x, average.y), 1e-3f);
+		float min_cell = std::sqrt(extent.x * extent.y / float(CellsPerBox * box_count));
+		cell_size_ = std::max(cell_size_, min_cell);
+	}
+	cell_size = cell_size_;
+	origin = lo;
+	cells = glm::uvec2(
+		uint32_t(std::floor(extent.x / cell_size)) + 1,
+		uint32_t(std::floor(extent.y / cell_size)) + 1
+	);
+
+	//count boxes per cell (offset by one for the prefix sum), then fill:
+	cell_start.assign(size_t(cells.x) * cells.y + 1, 0);
+	for (uint32_t i = 0; i < box_count; ++i) {
+		glm::ivec2 a = cell_of(mins[i]);
+		glm::ivec2 b = cell_of(maxs[i]);
+		if (uint32_t(b.x - a.x + 1) * uint32_t(b.y - a.y + 1) > LargeCells) continue;
+		for (int32_t y = a.y; y <= b.y; ++y) {
+			for (int32_t x = a.x; x <= b.x; ++x) {
+				cell_start[size_t(y) * cells.x + x + 1] += 1;
+			}
+		}
+	}
+	for (size_t c = 1; c < cell_start.size(); ++c) {
+		cell_start[c] += cell_start[c-1];
+	}
+	cell_items.resize(cell_start.back());
+
+	std::vector< uint32_t > &fill = scratch_fill;
+	fill.assign(cell_start.begin(), cell_start.end() - 1);
+	//(boxes are visited in index order, so each cell's list comes out sorted)
+	for (uint32_t i = 0; i < box_count; ++i) {
+		glm::ivec2 a = cell_of(mins[i]);
+		glm::ivec2 b = cell_of(maxs[i]);
+		if (uint32_t(b.x - a.x + 1) * uint32_t(b.y - a.y + 1) > LargeCells) {
+			large_items.emplace_back(i);
+			continue;
+		}
+		for (int32_t y = a.y; y <= b.y; ++y) {
+			for (int32_t x = a.x; x <= b.x; ++x) {
+				cell_items[fill[size_t(y) * cells.x + x]++] = i;
+			}
+		}
+	}
+	fill.clear();
+}
+
+BoxGrid::Arrays BoxGrid::arrays() const {
+	if (prebuilt_owner) return prebuilt;
+	Arrays ret;
+	ret.cell_start = cell_start;
+	ret.cell_items = cell_items;
+	ret.large_items = large_items;
+	return ret;
+}
+
+void BoxGrid::use_prebuilt(uint32_t box_count_, glm::vec2 const &origin_, float cell_size_, glm::uvec2 const &cells_, Arrays const &prebuilt_, std::shared_ptr< void const > const &owner) {
+	assert(owner);
+	assert(box_count_ == 0 || prebuilt_.cell_start.size() == size_t(cells_.x) * cells_.y + 1);
+	box_count = box_count_;
+	origin = origin_;
+	cell_size = cell_size_;
+	cells = cells_;
+	cell_start.clear();
+	cell_items.clear();
+	large_items.clear();
+	prebuilt = prebuilt_;
+	prebuilt_owner = owner;
+}
+
+void BoxGrid::query(glm::vec2 const &min, glm::vec2 const &max, std::vector< uint32_t > *out_) const {
+	assert(out_);
+	std::vector< uint32_t > &out = *out_;
+	out.clear();
+	if (box_count == 0) return;
+
+	Arrays const index = arrays();
+	out.insert(out.end(), index.large_items.begin(), index.large_items.end());
+
+	//rectangles entirely outside the grid can't touch any (cell-resident) box:
+	glm::vec2 hi = origin + glm::vec2(cells) * cell_size;
+	if (!(max.x < origin.x || max.y < origin.y || min.x > hi.x || min.y > hi.y)) {
+		glm::ivec2 a = cell_of(min);
+		glm::ivec2 b = cell_of(max);
+		for (int32_t y = a.y; y <= b.y; ++y) {
+			for (int32_t x = a.x; x <= b.x; ++x) {
+				size_t c = size_t(y) * cells.x + x;
+				out.insert(out.end(), index.cell_items.begin() + index.cell_start[c], index.cell_items.begin() + index.cell_start[c+1]);
+			}
+		}
+	}
+
+	//boxes that span several cells show up more than once; callers want index order:
+	if (out.size() > 1) {
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+}
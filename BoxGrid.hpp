@@ -0,0 +1,88 @@
+#pragma once
+
+#include "array_view.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+ * BoxGrid is a static uniform-grid broad-phase over a list of axis-aligned boxes.
+ *  It is built once (e.g., when a level is loaded) and then answers
+ *  "which boxes might overlap this rectangle?" by looking only at nearby cells.
+ *
+ * Everything is stored in flat arrays of plain values (compressed-row cell lists),
+ *  so the grid can be written to and read from disk as-is (see LevelFile.hpp, which stores
+ *  a prebuilt grid that use_prebuilt() then queries in place).
+ */
+
+struct BoxGrid {
+	//build from any list of boxes with 'position' (center) and 'radius' (half-size) members:
+	// 'cell_size' of zero picks a size from the boxes themselves
+	template< typename BOX >
+	void build(std::vector< BOX > const &boxes, float cell_size = 0.0f) {
+		//(bounds go in member scratch vectors, so rebuilding a grid of a similar size doesn't allocate)
+		std::vector< glm::vec2 > &mins = scratch_mins;
+		std::vector< glm::vec2 > &maxs = scratch_maxs;
+		mins.clear();
+		maxs.clear();
+		for (auto const &box : boxes) {
+			mins.emplace_back(box.position - box.radius);
+			maxs.emplace_back(box.position + box.radius);
+		}
+		build_from_bounds(mins, maxs, cell_size);
+		//(left empty, so copies of the grid don't copy them)
+		mins.clear();
+		maxs.clear();
+	}
+	void build_from_bounds(std::vector< glm::vec2 > const &mins, std::vector< glm::vec2 > const &maxs, float cell_size = 0.0f);
+
+	//the three index arrays below, wherever they are stored:
+	struct Arrays {
+		ArrayView< uint32_t > cell_start, cell_items, large_items;
+	};
+	Arrays arrays() const;
+
+	//query a grid built elsewhere (e.g., stored in a LevelFile) in place, rather than building one:
+	// 'prebuilt' must be laid out as build() would lay it out for 'box_count' boxes, 'origin', 'cell_size', and 'cells';
+	// 'owner' keeps the memory it points into alive for as long as this grid (or any copy of it) uses it
+	void use_prebuilt(uint32_t box_count, glm::vec2 const &origin, float cell_size, glm::uvec2 const &cells, Arrays const &prebuilt, std::shared_ptr< void const > const &owner);
+
+	//append the index of every box that could overlap [min,max] to 'out' (which is cleared first):
+	// results are sorted by index and contain no duplicates, so callers can test boxes in the same
+	// order as a linear scan would; every box that does overlap is included.
+	void query(glm::vec2 const &min, glm::vec2 const &max, std::vector< uint32_t > *out) const;
+
+	//number of boxes the grid was built from:
+	uint32_t box_count = 0;
+
+	//----- grid layout -----
+	glm::vec2 origin = glm::vec2(0.0f); //minimum corner of cell (0,0)
+	float cell_size = 1.0f;
+	glm::uvec2 cells = glm::uvec2(0); //grid dimensions (zero if there are no boxes)
+
+	//boxes overlapping cell (x,y) are cell_items[cell_start[c] .. cell_start[c+1]), c = y * cells.x + x, in increasing order:
+	std::vector< uint32_t > cell_start;
+	std::vector< uint32_t > cell_items;
+
+	//boxes too big to put in cells (they would fill too many), checked by every query:
+	std::vector< uint32_t > large_items;
+
+	//scratch space for build() and build_from_bounds() (always empty between builds, but keeps its capacity):
+	std::vector< glm::vec2 > scratch_mins, scratch_maxs;
+	std::vector< uint32_t > scratch_fill;
+
+	//prebuilt grids leave the vectors above empty and use these arrays instead:
+	Arrays prebuilt;
+	std::shared_ptr< void const > prebuilt_owner; //(null for grids made by build())
+
+	//boxes covering more than this many cells go in large_items:
+	static constexpr uint32_t LargeCells = 64;
+	//auto-sized grids have at most about this many cells per box:
+	static constexpr uint32_t CellsPerBox = 4;
+
+	//----- helpers -----
+	glm::ivec2 cell_of(glm::vec2 const &at) const;
+};
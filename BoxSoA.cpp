@@ -0,0 +1,22 @@
+#include "BoxSoA.hpp"
+
+#include <cassert>
+#include <limits>
+
+void BoxSoA::pad() {
+	//min = +inf, max = -inf: "min.x <= max_x" is false for every query:
+	float inf = std::numeric_limits< float >::infinity();
+	for (uint32_t i = count; i < min_x.size(); ++i) {
+		min_x[i] = inf; min_y[i] = inf;
+		max_x[i] = -inf; max_y[i] = -inf;
+	}
+}
+
+void BoxSoA::use_prebuilt(uint32_t count_, Arrays const &prebuilt_, std::shared_ptr< void const > const &owner) {
+	assert(owner);
+	count = count_;
+	min_x.clear(); min_y.clear();
+	max_x.clear(); max_y.clear();
+	prebuilt = prebuilt_;
+	prebuilt_owner = owner;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+//SIMD instruction set used by BoxSoA::overlap_mask:
+// (AVX2 builds need it enabled in the compiler -- 'jam -sAVX2=1'; SSE2 is always there on x86-64;
+//  anything else, e.g. ARM, uses the scalar loop)
+#if defined(__AVX2__)
+#define BOX_SOA_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOX_SOA_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+ * BoxSoA stores axis-aligned boxes as separate min.x / min.y / max.x / max.y arrays,
+ *  so one rectangle can be tested against several boxes per instruction.
+ * The arrays are padded with boxes that overlap nothing, so masks can be taken
+ *  starting at any box index without reading past the end.
+ * (LevelFile.hpp stores these arrays too; use_prebuilt() tests against them in place.)
+ */
+
+struct BoxSoA {
+	//build from any list of boxes with 'position' (center) and 'radius' (half-size) members:
+	template< typename BOX >
+	void build(std::vector< BOX > const &boxes) {
+		prebuilt = Arrays();
+		prebuilt_owner.reset();
+		count = uint32_t(boxes.size());
+		min_x.assign(count + Lanes, 0.0f);
+		min_y.assign(count + Lanes, 0.0f);
+		max_x.assign(count + Lanes, 0.0f);
+		max_y.assign(count + Lanes, 0.0f);
+		for (uint32_t i = 0; i < count; ++i) {
+			glm::vec2 min = boxes[i].position - boxes[i].radius;
+			glm::vec2 max = boxes[i].position + boxes[i].radius;
+			min_x[i] = min.x; min_y[i] = min.y;
+			max_x[i] = max.x; max_y[i] = max.y;
+		}
+		pad();
+	}
+
+	//boxes per mask:
+	static constexpr uint32_t Lanes = 8;
+
+	//bit i is set if box first+i overlaps [min,max] (touching counts, as in BouncSim's collision code):
+	// (any 'first' <= count is fine; bits for indices >= count are never set)
+	uint32_t overlap_mask(uint32_t first, glm::vec2 const &min, glm::vec2 const &max) const;
+	//plain loop version of the same thing (the reference the SIMD versions must match):
+	uint32_t overlap_mask_scalar(uint32_t first, glm::vec2 const &min, glm::vec2 const &max) const;
+
+	uint32_t count = 0; //number of real boxes; arrays hold count + Lanes entries
+	std::vector< float > min_x, min_y, max_x, max_y;
+
+	//the four arrays, wherever they are stored:
+	struct Arrays {
+		float const *min_x = nullptr, *min_y = nullptr, *max_x = nullptr, *max_y = nullptr;
+	};
+	Arrays arrays() const;
+
+	//test against arrays stored elsewhere (e.g., in a LevelFile) in place, rather than building them:
+	// each must hold 'count' + Lanes entries, padded as pad() pads them;
+	// 'owner' keeps that memory alive for as long as this (or any copy of it) uses it
+	void use_prebuilt(uint32_t count, Arrays const &prebuilt, std::shared_ptr< void const > const &owner);
+	//prebuilt arrays leave the vectors above empty and use these instead:
+	Arrays prebuilt;
+	std::shared_ptr< void const > prebuilt_owner; //(null for arrays made by build())
+
+	//fill the entries after 'count' with boxes that overlap nothing:
+	void pad();
+};
+
+inline BoxSoA::Arrays BoxSoA::arrays() const {
+	if (prebuilt_owner) return prebuilt;
+	Arrays ret;
+	ret.min_x = min_x.data(); ret.min_y = min_y.data();
+	ret.max_x = max_x.data(); ret.max_y = max_y.data();
+	return ret;
+}
+
+inline uint32_t BoxSoA::overlap_mask_scalar(uint32_t first, glm::vec2 const &min, glm::vec2 const &max) const {
+	Arrays const a = arrays();
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < Lanes; ++i) {
+		uint32_t b = first + i;
+		bool hit = (min.x <= a.max_x[b]) & (a.min_x[b] <= max.x) & (min.y <= a.max_y[b]) & (a.min_y[b] <= max.y);
+		mask |= uint32_t(hit) << i;
+	}
+	return mask;
+}
+
+inline uint32_t BoxSoA::overlap_mask(uint32_t first, glm::vec2 const &min, glm::vec2 const &max) const {
+#if defined(BOX_SOA_AVX2) || defined(BOX_SOA_SSE2)
+	Arrays const a = arrays();
+#endif
+#if defined(BOX_SOA_AVX2)
+	__m256 hit = _mm256_and_ps(
+		_mm256_and_ps(
+			_mm256_cmp_ps(_mm256_set1_ps(min.x), _mm256_loadu_ps(&a.max_x[first]), _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_loadu_ps(&a.min_x[first]), _mm256_set1_ps(max.x), _CMP_LE_OQ)
+		),
+		_mm256_and_ps(
+			_mm256_cmp_ps(_mm256_set1_ps(min.y), _mm256_loadu_ps(&a.max_y[first]), _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_loadu_ps(&a.min_y[first]), _mm256_set1_ps(max.y), _CMP_LE_OQ)
+		)
+	);
+	return uint32_t(_mm256_movemask_ps(hit));
+#elif defined(BOX_SOA_SSE2)
+	__m128 qmin_x = _mm_set1_ps(min.x), qmin_y = _mm_set1_ps(min.y);
+	__m128 qmax_x = _mm_set1_ps(max.x), qmax_y = _mm_set1_ps(max.y);
+	uint32_t mask = 0;
+	for (uint32_t half = 0; half < Lanes; half += 4) {
+		uint32_t b = first + half;
+		__m128 hit = _mm_and_ps(
+			_mm_and_ps(_mm_cmple_ps(qmin_x, _mm_loadu_ps(&a.max_x[b])), _mm_cmple_ps(_mm_loadu_ps(&a.min_x[b]), qmax_x)),
+			_mm_and_ps(_mm_cmple_ps(qmin_y, _mm_loadu_ps(&a.max_y[b])), _mm_cmple_ps(_mm_loadu_ps(&a.min_y[b]), qmax_y))
+		);
+		mask |= uint32_t(_mm_movemask_ps(hit)) << half;
+	}
+	return mask;
+#else
+	return overlap_mask_scalar(first, min, max);
+#endif
+}
@@ -2,8 +2,11 @@
 
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
+#include "startup_report.hpp"
 
 ColorTextureProgram::ColorTextureProgram() {
+	STARTUP_STAGE("ColorTextureProgram");
+
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
 	program = gl_compile_program(
 		//vertex shader:
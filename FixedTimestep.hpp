@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ * FixedTimestep turns variable frame times into a whole number of fixed-length ticks.
+ *  Shared by the main loop and by headless input replay (replay.cpp), so that both
+ *  split the same recorded frame times into exactly the same sequence of ticks.
+ */
+
+struct FixedTimestep {
+	explicit FixedTimestep(float tick_rate) : tick(1.0f / tick_rate) { }
+
+	//add 'elapsed' seconds of (already clamped) frame time:
+	void accumulate(float elapsed) {
+		accumulator += elapsed;
+	}
+
+	//consume one tick if enough time has accumulated; use as 'while (timestep.step()) update(timestep.tick);':
+	bool step() {
+		if (accumulator < tick) return false;
+		accumulator -= tick;
+		return true;
+	}
+
+	//fraction of a tick between the last update and now, used to interpolate when drawing:
+	float alpha() const {
+		return accumulator / tick;
+	}
+
+	float const tick; //length of a tick in seconds
+	float accumulator = 0.0f; //frame time not yet consumed by ticks
+};
@@ -0,0 +1,35 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+FrameArena::FrameArena(size_t capacity) : block(new char[capacity]), block_size(capacity) {
+}
+
+void FrameArena::reset() {
+	//last frame didn't fit, so make room for all of it (and then some) in one block:
+	if (!overflow.empty()) {
+		size_t needed = used();
+		block_size = std::max(block_size * 2, needed + needed / 2);
+		block.reset(new char[block_size]);
+		overflow.clear();
+	}
+	block_used = 0;
+	overflow_used = 0;
+}
+
+void *FrameArena::allocate(size_t bytes, size_t alignment) {
+	assert(alignment && (alignment & (alignment - 1)) == 0 && alignment <= alignof(std::max_align_t));
+	if (bytes == 0) bytes = 1;
+
+	size_t begin = (block_used + alignment - 1) & ~(alignment - 1);
+	if (begin + bytes <= block_size) {
+		block_used = begin + bytes;
+		return block.get() + begin;
+	}
+
+	//out of room; give this allocation a heap block of its own (new[] storage is suitably aligned):
+	overflow.emplace_back(new char[bytes]);
+	overflow_used += bytes;
+	return overflow.back().get();
+}
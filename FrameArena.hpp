@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * FrameArena is a linear (bump) allocator for things that only live for one frame,
+ *  e.g., the vertex lists a mode's draw() builds:
+ *
+ *   void SomeMode::draw(...) {
+ *     frame_arena.reset(); //everything from the last frame is gone
+ *     FrameVector< Vertex > vertices(frame_arena);
+ *     ...
+ *
+ * Allocating is a pointer bump; freeing does nothing, and reset() drops everything at once.
+ * If a frame needs more than the arena holds, the extra comes from the heap, and the next
+ *  reset() grows the arena to fit, so once frames are a steady size they never touch the heap.
+ *
+ * Not thread-safe: each arena belongs to whichever thread is drawing.
+ */
+
+struct FrameArena {
+	explicit FrameArena(size_t capacity = 64 * 1024);
+	FrameArena(FrameArena const &) = delete;
+	FrameArena &operator=(FrameArena const &) = delete;
+
+	//start a new frame (invalidates everything allocated so far):
+	void reset();
+
+	//'bytes' of storage aligned to 'alignment' (a power of two, at most alignof(std::max_align_t)):
+	void *allocate(size_t bytes, size_t alignment);
+
+	size_t capacity() const { return block_size; }
+	//bytes handed out since the last reset (including any that overflowed onto the heap):
+	size_t used() const { return block_used + overflow_used; }
+
+	//----- internals -----
+	std::unique_ptr< char[] > block;
+	size_t block_size = 0;
+	size_t block_used = 0;
+
+	//heap blocks for allocations that didn't fit this frame (freed by reset()):
+	std::vector< std::unique_ptr< char[] > > overflow;
+	size_t overflow_used = 0;
+};
+
+//standard allocator interface on a FrameArena, for containers (deallocate does nothing):
+template< typename T >
+struct FrameAllocator {
+	typedef T value_type;
+
+	FrameAllocator(FrameArena &arena_) : arena(&arena_) { }
+	template< typename U >
+	FrameAllocator(FrameAllocator< U > const &other) : arena(other.arena) { }
+
+	T *allocate(size_t count) {
+		return static_cast< T * >(arena->allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T *, size_t) { }
+
+	template< typename U >
+	bool operator==(FrameAllocator< U > const &other) const { return arena == other.arena; }
+	template< typename U >
+	bool operator!=(FrameAllocator< U > const &other) const { return arena != other.arena; }
+
+	FrameArena *arena;
+};
+
+//a vector that lives in a FrameArena:
+template< typename T >
+using FrameVector = std::vector< T, FrameAllocator< T > >;
@@ -0,0 +1,173 @@
+#include "FrameCapture.hpp"
+
+//for the GL_ERRORS() macro:
+#include "gl_errors.hpp"
+
+#include "profile_zones.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+FrameCapture::FrameCapture(uint32_t workers, size_t max_queued, PngWriter::Overflow overflow) : writer(workers, max_queued, overflow) {
+	for (auto &slot : slots) {
+		glGenBuffers(1, &slot.pbo);
+	}
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+FrameCapture::~FrameCapture() {
+	if (sequence_active) stop_sequence();
+
+	for (auto &slot : slots) {
+		if (slot.fence) {
+			//make sure the readback is submitted, then wait for it:
+			glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)); //1s
+			finish(slot);
+		}
+		glDeleteBuffers(1, &slot.pbo);
+		slot.pbo = 0;
+	}
+	//(writer's destructor then finishes writing everything queued)
+}
+
+bool FrameCapture::capture(glm::uvec2 const &size, std::string const &filename) {
+	PROFILE_ZONE("FrameCapture::capture");
+
+	Slot *free_slot = nullptr;
+	for (auto &slot : slots) {
+		if (!slot.fence) {
+			free_slot = &slot;
+			break;
+		}
+	}
+	if (!free_slot) return false;
+	Slot &slot = *free_slot;
+
+	slot.size = size;
+	slot.filename = filename;
+
+	GLsizeiptr bytes = GLsizeiptr(size.x) * size.y * 4;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	if (slot.pbo_bytes != bytes) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		slot.pbo_bytes = bytes;
+	}
+
+	//with a pack buffer bound, glReadPixels writes to the buffer (at offset zero) and returns immediately:
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid *)0);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	//fence so poll() can tell when the copy is done:
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	return true;
+}
+
+void FrameCapture::poll() {
+	for (auto &slot : slots) {
+		if (!slot.fence) continue;
+		//zero timeout: just check whether the readback has completed:
+		GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			finish(slot);
+		} else if (status == GL_WAIT_FAILED) {
+			std::cerr << "WARNING: frame capture fence wait failed; dropping '" << slot.filename << "'." << std::endl;
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+		}
+	}
+}
+
+void FrameCapture::finish(Slot &slot) {
+	PROFILE_ZONE("FrameCapture::finish");
+
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	//make sure the writer has room before copying a whole frame out of the buffer:
+	if (!writer.reserve()) return; //(the writer counts the drop)
+
+	PngWriter::Job job;
+	job.filename = slot.filename;
+	job.size = slot.size;
+	job.data = writer.take_buffer(); //(storage from an already-written frame, so same-sized frames don't allocate)
+	job.data.resize(size_t(slot.size.x) * slot.size.y);
+	job.origin = LowerLeftOrigin;
+	job.force_opaque = true; //the framebuffer's alpha channel isn't meaningful
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	void const *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.pbo_bytes, GL_MAP_READ_BIT);
+	if (pixels) {
+		std::memcpy(job.data.data(), pixels, job.data.size() * sizeof(job.data[0]));
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+
+	if (!pixels) {
+		std::cerr << "WARNING: failed to map frame capture buffer; dropping '" << slot.filename << "'." << std::endl;
+		writer.unreserve();
+		return;
+	}
+	writer.enqueue(std::move(job), true);
+}
+
+void FrameCapture::start_sequence(std::string const &prefix, uint32_t every) {
+	if (sequence_active) stop_sequence();
+	sequence_active = true;
+	sequence_prefix = prefix;
+	sequence_every = std::max(every, 1U);
+	sequence_frames = 0;
+	sequence_index = 0;
+	sequence_written_base = writer.written.load();
+	sequence_dropped_base = writer.dropped.load();
+	readback_dropped = 0;
+	sequence_start = last_report = std::chrono::steady_clock::now();
+	std::cout << "Capturing every " << sequence_every << " frame(s) to '" << sequence_prefix << "NNNNNN.png'." << std::endl;
+}
+
+void FrameCapture::stop_sequence() {
+	if (!sequence_active) return;
+	report();
+	sequence_active = false;
+	std::cout << "Stopped capturing." << std::endl;
+}
+
+void FrameCapture::sequence_frame(glm::uvec2 const &drawable_size) {
+	if (!sequence_active) return;
+
+	if (sequence_frames % sequence_every == 0) {
+		char number[32];
+		snprintf(number, sizeof(number), "%06llu", (unsigned long long)sequence_index);
+		if (!capture(drawable_size, sequence_prefix + number + ".png")) {
+			++readback_dropped;
+		}
+		++sequence_index;
+	}
+	++sequence_frames;
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - last_report > std::chrono::seconds(2)) {
+		report();
+		last_report = now;
+	}
+}
+
+void FrameCapture::report() {
+	float seconds = std::chrono::duration< float >(std::chrono::steady_clock::now() - sequence_start).count();
+	uint64_t written = writer.written.load() - sequence_written_base;
+	uint64_t queue_dropped = writer.dropped.load() - sequence_dropped_base;
+	std::cout << "Capture: " << written << " frames written in " << seconds << "s ("
+		<< (seconds > 0.0f ? written / seconds : 0.0f) << " fps sustained); "
+		<< "queue depth " << writer.queue_depth() << " (max " << writer.max_depth.load() << ", limit " << writer.max_queued << "); "
+		<< "dropped " << readback_dropped << " at readback, " << queue_dropped << " at queue." << std::endl;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "PngWriter.hpp"
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <chrono>
+#include <string>
+
+/*
+ * FrameCapture reads back the default framebuffer without stalling:
+ *  capture() starts an asynchronous glReadPixels into a pixel buffer object,
+ *  and poll() (called once per frame) maps the buffers whose readback has
+ *  finished -- typically a frame or two later -- and hands the pixels to a
+ *  PngWriter to be encoded on background threads.
+ * It can also record a continuous, numbered sequence of every Nth frame
+ *  (for recording sessions); frames that can't be read back or queued in
+ *  time are dropped and counted rather than stalling the game.
+ */
+
+struct FrameCapture {
+	//(arguments configure the PngWriter pool that encodes captured frames)
+	explicit FrameCapture(uint32_t workers = 1, size_t max_queued = 0, PngWriter::Overflow overflow = PngWriter::Overflow::Drop);
+	~FrameCapture(); //waits for pending readbacks so they still get saved
+
+	//start reading back the back buffer (call after drawing, before swapping);
+	// returns false (and captures nothing) if all readback slots are busy:
+	bool capture(glm::uvec2 const &size, std::string const &filename);
+
+	//hand off any finished readbacks to the writer; never blocks (unless the writer uses Overflow::Block):
+	void poll();
+
+	//----- continuous capture -----
+	//capture every 'every'-th frame to '<prefix>NNNNNN.png' until stop_sequence():
+	void start_sequence(std::string const &prefix, uint32_t every);
+	void stop_sequence(); //prints a final report
+	//call once per frame after drawing; no-op unless a sequence is running:
+	void sequence_frame(glm::uvec2 const &drawable_size);
+	//print sustained capture rate, queue depth, and drop counts:
+	void report();
+
+	bool sequence_active = false;
+	std::string sequence_prefix;
+	uint32_t sequence_every = 1;
+	uint64_t sequence_frames = 0; //frames seen since the sequence started
+	uint64_t sequence_index = 0; //next file number (dropped frames leave gaps)
+	uint64_t sequence_written_base = 0; //writer.written when the sequence started
+	uint64_t sequence_dropped_base = 0; //writer.dropped when the sequence started
+	uint64_t readback_dropped = 0; //sequence frames skipped because all slots were busy
+	std::chrono::steady_clock::time_point sequence_start;
+	std::chrono::steady_clock::time_point last_report;
+
+	//----- internals -----
+	struct Slot {
+		GLuint pbo = 0;
+		GLsizeiptr pbo_bytes = 0; //allocated size of pbo
+		GLsync fence = 0; //non-zero while a readback is in flight
+		glm::uvec2 size = glm::uvec2(0);
+		std::string filename;
+	};
+	static constexpr uint32_t Slots = 4;
+	std::array< Slot, Slots > slots;
+
+	//map slot's buffer and queue its pixels for writing:
+	void finish(Slot &slot);
+
+	PngWriter writer;
+};
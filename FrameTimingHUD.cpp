@@ -0,0 +1,149 @@
+#include "FrameTimingHUD.hpp"
+
+//for the GL_ERRORS() macro:
+#include "gl_errors.hpp"
+
+//for glm::value_ptr() :
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+FrameTimingHUD::FrameTimingHUD() {
+	stats_scratch.reserve(FrameTimings::Capacity);
+
+	//(same vertex layout as the modes; see BouncMode.cpp for a commented version)
+	glGenBuffers(1, &vertex_buffer);
+
+	glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+	glVertexAttribPointer(color_texture_program.Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0 + 0);
+	glEnableVertexAttribArray(color_texture_program.Position_vec4);
+	glVertexAttribPointer(color_texture_program.Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLbyte *)0 + 4*3);
+	glEnableVertexAttribArray(color_texture_program.Color_vec4);
+	glVertexAttribPointer(color_texture_program.TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0 + 4*3 + 4*1);
+	glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	glGenTextures(1, &white_tex);
+	glBindTexture(GL_TEXTURE_2D, white_tex);
+	glm::u8vec4 white(0xff, 0xff, 0xff, 0xff);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	vertices.reserve((Bars * FrameTimings::PhaseCount + 8) * 6);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+FrameTimingHUD::~FrameTimingHUD() {
+	glDeleteBuffers(1, &vertex_buffer);
+	vertex_buffer = 0;
+
+	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
+	vertex_buffer_for_color_texture_program = 0;
+
+	glDeleteTextures(1, &white_tex);
+	white_tex = 0;
+}
+
+void FrameTimingHUD::draw(FrameTimings const &timings, glm::uvec2 const &drawable_size) {
+	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
+	const glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x000000aa);
+	const glm::u8vec4 phase_colors[FrameTimings::PhaseCount] = {
+		HEX_TO_U8VEC4(0x6fb1e3ff), //Events
+		HEX_TO_U8VEC4(0x8ddb72ff), //Update
+		HEX_TO_U8VEC4(0xf2ad5cff), //Draw
+		HEX_TO_U8VEC4(0x5a5a6aff), //Swap
+	};
+	const glm::u8vec4 budget_color = HEX_TO_U8VEC4(0xffffff55); //16.7ms reference line
+	const glm::u8vec4 p50_color = HEX_TO_U8VEC4(0x55ff55ff);
+	const glm::u8vec4 p99_color = HEX_TO_U8VEC4(0xffff55ff);
+	const glm::u8vec4 max_color = HEX_TO_U8VEC4(0xff5555ff);
+	#undef HEX_TO_U8VEC4
+
+	if (frames_since_stats >= stats_interval) {
+		stats = timings.stats(&stats_scratch);
+		frames_since_stats = 0;
+	}
+	++frames_since_stats;
+
+	//---- compute vertices to draw (in pixels, origin at lower left) ----
+	vertices.clear();
+
+	auto draw_rectangle = [this](glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color) {
+		vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+
+		vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(min.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	};
+
+	const float margin = 10.0f;
+	const float px_per_ms = graph_height / graph_ms;
+	glm::vec2 origin = glm::vec2(margin, margin);
+	float width = Bars * bar_width;
+
+	draw_rectangle(origin, origin + glm::vec2(width, graph_height), bg_color);
+
+	//bars, newest on the right, phases stacked bottom to top:
+	uint32_t count = std::min(timings.size(), uint32_t(Bars));
+	for (uint32_t i = 0; i < count; ++i) {
+		FrameTimings::Frame const &frame = timings.recent(i);
+		float x = origin.x + width - (i + 1) * bar_width;
+		float y = origin.y;
+		for (uint32_t p = 0; p < FrameTimings::PhaseCount; ++p) {
+			float h = std::min(frame.phase_ms[p] * px_per_ms, origin.y + graph_height - y);
+			if (h <= 0.0f) continue;
+			draw_rectangle(glm::vec2(x, y), glm::vec2(x + bar_width, y + h), phase_colors[p]);
+			y += h;
+		}
+	}
+
+	//markers:
+	auto draw_marker = [&](float ms, glm::u8vec4 const &color) {
+		float y = origin.y + std::min(ms * px_per_ms, graph_height);
+		draw_rectangle(glm::vec2(origin.x, y - 0.5f), glm::vec2(origin.x + width, y + 0.5f), color);
+	};
+	draw_marker(1000.0f / 60.0f, budget_color);
+	draw_marker(stats.p50_ms, p50_color);
+	draw_marker(stats.p99_ms, p99_color);
+	draw_marker(stats.max_ms, max_color);
+
+	//---- actual drawing ----
+
+	//pixels to clip space:
+	glm::mat4 pixel_to_clip = glm::mat4(
+		glm::vec4(2.0f / drawable_size.x, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 2.0f / drawable_size.y, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f)
+	);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_DEPTH_TEST);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(color_texture_program.program);
+	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(pixel_to_clip));
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, white_tex);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ColorTextureProgram.hpp"
+#include "FrameTimings.hpp"
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * FrameTimingHUD draws a stacked bar graph of recent FrameTimings over the
+ *  current framebuffer, with horizontal markers for p50 / p99 / max frame time.
+ */
+
+struct FrameTimingHUD {
+	FrameTimingHUD();
+	~FrameTimingHUD();
+
+	void draw(FrameTimings const &timings, glm::uvec2 const &drawable_size);
+
+	//----- layout -----
+	static constexpr uint32_t Bars = 300; //most recent frames shown
+	float bar_width = 2.0f; //pixels
+	float graph_height = 150.0f; //pixels
+	float graph_ms = 50.0f; //frame time at the top of the graph
+
+	//percentiles are recomputed every few frames, since they need a sort:
+	uint32_t stats_interval = 30;
+	uint32_t frames_since_stats = -1U;
+	FrameTimings::Stats stats;
+	std::vector< float > stats_scratch; //(reserved up front, so recomputing doesn't allocate)
+
+	//----- opengl assets / helpers ------
+
+	struct Vertex {
+		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+		glm::vec3 Position;
+		glm::u8vec4 Color;
+		glm::vec2 TexCoord;
+	};
+	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "FrameTimingHUD::Vertex should be packed");
+
+	//kept between frames so steady-state drawing doesn't allocate:
+	std::vector< Vertex > vertices;
+
+	ColorTextureProgram color_texture_program;
+	GLuint vertex_buffer = 0;
+	GLuint vertex_buffer_for_color_texture_program = 0;
+	GLuint white_tex = 0;
+};
@@ -0,0 +1,43 @@
+#include "FrameTimings.hpp"
+
+#include <algorithm>
+
+float FrameTimings::Frame::total_ms() const {
+	float total = 0.0f;
+	for (float ms : phase_ms) {
+		total += ms;
+	}
+	return total;
+}
+
+FrameTimings::Stats FrameTimings::stats(std::vector< float > *scratch) const {
+	Stats ret;
+	uint32_t count = size();
+	if (count == 0) return ret;
+
+	std::vector< float > &totals = *scratch;
+	totals.clear();
+	for (uint32_t i = 0; i < count; ++i) {
+		totals.emplace_back(recent(i).total_ms());
+	}
+
+	//nearest-rank percentiles:
+	auto percentile = [&totals](float p) {
+		size_t rank = std::min(totals.size() - 1, size_t(p * totals.size()));
+		std::nth_element(totals.begin(), totals.begin() + rank, totals.end());
+		return totals[rank];
+	};
+	ret.p50_ms = percentile(0.50f);
+	ret.p99_ms = percentile(0.99f);
+	ret.max_ms = *std::max_element(totals.begin(), totals.end());
+
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t allocations = recent(i).allocations;
+		if (allocations == 0) continue;
+		ret.allocations += allocations;
+		ret.allocating_frames += 1;
+		ret.frames_since_allocation = std::min(ret.frames_since_allocation, i);
+	}
+
+	return ret;
+}
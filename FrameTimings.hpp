@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/*
+ * FrameTimings keeps a fixed-size history of how long each phase of the
+ *  main loop took, for the last 'Capacity' frames.
+ * Recording is a couple of stores per phase, so it is cheap enough to leave on.
+ */
+
+struct FrameTimings {
+	//phases of the main loop, in the order they happen:
+	enum Phase : uint32_t {
+		Events, //SDL_PollEvent + Mode::handle_event
+		Update, //Mode::update (all ticks this frame)
+		Draw, //Mode::draw
+		Swap, //SDL_GL_SwapWindow (includes waiting for vsync)
+		PhaseCount
+	};
+
+	static constexpr uint32_t Capacity = 4096; //frames of history (power of two)
+
+	//per-frame record, times in milliseconds:
+	struct Frame {
+		std::array< float, PhaseCount > phase_ms;
+		uint32_t allocations; //heap allocations (on any thread) since the previous frame ended
+		float total_ms() const;
+	};
+
+	//record the time spent in 'phase' during the current frame:
+	void record(Phase phase, float ms) {
+		frames[next % Capacity].phase_ms[phase] = ms;
+	}
+
+	//record the heap allocations made during the current frame:
+	void record_allocations(uint32_t count) {
+		frames[next % Capacity].allocations = count;
+	}
+
+	//finish the current frame (it becomes part of the history) and start a new one:
+	void end_frame() {
+		++next;
+		frames[next % Capacity].phase_ms.fill(0.0f);
+		frames[next % Capacity].allocations = 0;
+	}
+
+	//number of completed frames available (at most Capacity):
+	uint32_t size() const { return next < Capacity ? uint32_t(next) : Capacity; }
+
+	//i-th most recent completed frame (0 is the newest); requires i < size():
+	Frame const &recent(uint32_t i) const { return frames[(next - 1 - i) % Capacity]; }
+
+	//order statistics of total frame time over the recorded history:
+	// (and heap allocation totals, since steady-state frames shouldn't allocate at all)
+	struct Stats {
+		float p50_ms = 0.0f;
+		float p99_ms = 0.0f;
+		float max_ms = 0.0f;
+		uint64_t allocations = 0;
+		uint32_t allocating_frames = 0; //frames with any allocations
+		uint32_t frames_since_allocation = -1U; //how many frames ago the most recent allocating frame was (-1U if none were)
+	};
+	//'scratch' holds the frame totals while they're sorted, so reserve Capacity in it up front to never allocate here:
+	Stats stats(std::vector< float > *scratch) const;
+
+	std::array< Frame, Capacity > frames{};
+	uint64_t next = 0; //total frames ever ended; the current frame is frames[next % Capacity]
+};
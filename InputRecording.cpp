@@ -0,0 +1,147 @@
+#include "InputRecording.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static char const Magic[8] = {'B','N','C','R','E','C','0','1'};
+
+template< typename T >
+static void write(std::ostream &to, T const &value) {
+	to.write(reinterpret_cast< char const * >(&value), sizeof(value));
+}
+
+template< typename T >
+static bool read(std::istream &from, T *value) {
+	return bool(from.read(reinterpret_cast< char * >(value), sizeof(*value)));
+}
+
+bool InputRecording::from_sdl(SDL_Event const &evt, glm::uvec2 const &window_size, glm::uvec2 const &drawable_size, Event *out) {
+	Event &event = *out;
+	event = Event();
+	event.type = evt.type;
+	if (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) {
+		event.a = evt.key.keysym.sym;
+		event.b = evt.key.repeat;
+	} else if (evt.type == SDL_MOUSEBUTTONDOWN || evt.type == SDL_MOUSEBUTTONUP) {
+		event.a = evt.button.x;
+		event.b = evt.button.y;
+		event.c = evt.button.button;
+		event.d = evt.button.clicks;
+	} else if (evt.type == SDL_MOUSEMOTION) {
+		event.a = evt.motion.x;
+		event.b = evt.motion.y;
+		event.c = evt.motion.xrel;
+		event.d = evt.motion.yrel;
+	} else if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+		event.a = int32_t(window_size.x);
+		event.b = int32_t(window_size.y);
+		event.c = int32_t(drawable_size.x);
+		event.d = int32_t(drawable_size.y);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+SDL_Event InputRecording::to_sdl(Event const &event) {
+	SDL_Event evt;
+	std::memset(&evt, 0, sizeof(evt));
+	evt.type = event.type;
+	if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+		evt.key.state = (event.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED);
+		evt.key.keysym.sym = SDL_Keycode(event.a);
+		evt.key.repeat = uint8_t(event.b);
+	} else if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP) {
+		evt.button.state = (event.type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED);
+		evt.button.x = event.a;
+		evt.button.y = event.b;
+		evt.button.button = uint8_t(event.c);
+		evt.button.clicks = uint8_t(event.d);
+	} else if (event.type == SDL_MOUSEMOTION) {
+		evt.motion.x = event.a;
+		evt.motion.y = event.b;
+		evt.motion.xrel = event.c;
+		evt.motion.yrel = event.d;
+	} else if (event.type == SDL_WINDOWEVENT) {
+		evt.window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+		evt.window.data1 = event.a;
+		evt.window.data2 = event.b;
+	}
+	return evt;
+}
+
+void InputRecording::load(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open input recording '" + filename + "'.");
+	}
+
+	char magic[8];
+	char mode_name[9] = {0}; //(8 bytes in the file, plus a terminator)
+	uint32_t sizes[4];
+	if (!read(file, &magic) || std::memcmp(magic, Magic, sizeof(Magic)) != 0) {
+		throw std::runtime_error("'" + filename + "' is not an input recording.");
+	}
+	if (!file.read(mode_name, 8) || !read(file, &tick_rate) || !read(file, &sizes)) {
+		throw std::runtime_error("Input recording '" + filename + "' has a truncated header.");
+	}
+	mode = mode_name;
+	window_size = glm::uvec2(sizes[0], sizes[1]);
+	drawable_size = glm::uvec2(sizes[2], sizes[3]);
+
+	frames.clear();
+	while (true) {
+		Frame frame;
+		uint32_t count;
+		if (!read(file, &frame.elapsed)) break; //end of file
+		if (!read(file, &count)) {
+			throw std::runtime_error("Input recording '" + filename + "' has a truncated frame.");
+		}
+		frame.events.resize(count);
+		if (count && !file.read(reinterpret_cast< char * >(frame.events.data()), count * sizeof(Event))) {
+			throw std::runtime_error("Input recording '" + filename + "' has a truncated frame.");
+		}
+		frames.emplace_back(std::move(frame));
+	}
+}
+
+InputRecorder::InputRecorder(std::string const &filename_, std::string const &mode, float tick_rate, glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) : filename(filename_) {
+	out.open(filename, std::ios::binary);
+	if (!out) {
+		throw std::runtime_error("Failed to open '" + filename + "' for recording input.");
+	}
+
+	char mode_name[8] = {0};
+	std::memcpy(mode_name, mode.c_str(), std::min(mode.size(), sizeof(mode_name)));
+	uint32_t sizes[4] = {window_size.x, window_size.y, drawable_size.x, drawable_size.y};
+	write(out, Magic);
+	write(out, mode_name);
+	write(out, tick_rate);
+	write(out, sizes);
+}
+
+void InputRecorder::event(SDL_Event const &evt, glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) {
+	InputRecording::Event event;
+	if (InputRecording::from_sdl(evt, window_size, drawable_size, &event)) {
+		pending.emplace_back(event);
+	}
+}
+
+void InputRecorder::restart(bool gets_frame_events) {
+	InputRecording::Event event;
+	event.type = InputRecording::Restart;
+	pending.insert(gets_frame_events ? pending.begin() : pending.end(), event);
+}
+
+void InputRecorder::end_frame(float elapsed) {
+	uint32_t count = uint32_t(pending.size());
+	write(out, elapsed);
+	write(out, count);
+	if (count) {
+		out.write(reinterpret_cast< char const * >(pending.data()), count * sizeof(InputRecording::Event));
+	}
+	frames += 1;
+	events += count;
+	pending.clear();
+}
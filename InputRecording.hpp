@@ -0,0 +1,78 @@
+#pragma once
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Compact binary log of the input a Mode received, for deterministic headless replay
+ *  (see replay.cpp, built as 'bounc-replay').
+ *
+ * File layout (host byte order):
+ *   header: "BNCREC01", mode name (char[8], zero padded), float tick_rate,
+ *           uint32 window w,h and drawable w,h at startup
+ *   then one record per frame:
+ *           float elapsed (after clamping), uint32 event count, that many Events
+ *
+ * Only the event types the modes look at are stored (keys, mouse buttons, mouse motion, resizes),
+ *  plus a Restart marker where the game swapped in a fresh mode (F5), so replay can do the same.
+ */
+
+struct InputRecording {
+	//one recorded SDL event (20 bytes):
+	struct Event {
+		uint32_t type = 0; //SDL_EventType
+		int32_t a = 0, b = 0, c = 0, d = 0;
+		//key up/down: sym, repeat
+		//mouse button up/down: x, y, button, clicks
+		//mouse motion: x, y, xrel, yrel
+		//window size changed: window w, h; drawable w, h
+	};
+	static_assert(sizeof(Event) == 20, "InputRecording::Event should be packed");
+
+	//Event::type of the restart marker (outside the range of SDL_EventType):
+	// events before it in a frame went to the old mode, events after it to the new one
+	enum : uint32_t { Restart = 0x10000 };
+
+	struct Frame {
+		float elapsed = 0.0f;
+		std::vector< Event > events;
+	};
+
+	std::string mode;
+	float tick_rate = 60.0f;
+	glm::uvec2 window_size = glm::uvec2(0);
+	glm::uvec2 drawable_size = glm::uvec2(0);
+	std::vector< Frame > frames;
+
+	//NOTE: load will throw on error
+	void load(std::string const &filename);
+
+	//convert to and from SDL events; returns false for event types that are not recorded:
+	static bool from_sdl(SDL_Event const &evt, glm::uvec2 const &window_size, glm::uvec2 const &drawable_size, Event *out);
+	static SDL_Event to_sdl(Event const &event);
+};
+
+//streams frames to disk as the game runs:
+struct InputRecorder {
+	//NOTE: constructor will throw if the file can't be opened
+	InputRecorder(std::string const &filename, std::string const &mode, float tick_rate, glm::uvec2 const &window_size, glm::uvec2 const &drawable_size);
+
+	//call with every event passed to Mode::handle_event (after any resize has been applied):
+	void event(SDL_Event const &evt, glm::uvec2 const &window_size, glm::uvec2 const &drawable_size);
+	//call when a fresh mode is swapped in, with whether it also gets the events already logged this frame:
+	// (when pipelined, this frame's events are handed to the simulation after the swap)
+	void restart(bool gets_frame_events);
+	//call once per frame with the clamped frame time, before updating:
+	void end_frame(float elapsed);
+
+	std::string filename;
+	std::ofstream out;
+	std::vector< InputRecording::Event > pending; //events for the current frame
+	uint64_t frames = 0;
+	uint64_t events = 0;
+};
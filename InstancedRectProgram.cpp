@@ -0,0 +1,88 @@
+#include "InstancedRectProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+#include "startup_report.hpp"
+
+InstancedRectProgram::InstancedRectProgram() {
+	STARTUP_STAGE("InstancedRectProgram");
+
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec2 Center;\n"
+		"in vec2 Radius;\n"
+		"in vec4 Color;\n"
+		"in float Lean;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		//rectangle as two CCW-oriented triangles:
+		"	const vec2 corners[6] = vec2[6](\n"
+		"		vec2(-1.0,-1.0), vec2( 1.0,-1.0), vec2( 1.0, 1.0),\n"
+		"		vec2(-1.0,-1.0), vec2( 1.0, 1.0), vec2(-1.0, 1.0)\n"
+		"	);\n"
+		"	vec2 corner = corners[gl_VertexID];\n"
+		"	vec2 position = Center + corner * Radius;\n"
+		//lean displaces whichever top corner is on the side it points to:
+		"	if (corner.y > 0.0) {\n"
+		"		if (corner.x > 0.0) position += vec2(max(Lean, 0.0));\n"
+		"		else position += vec2(min(Lean, 0.0), max(-Lean, 0.0));\n"
+		"	}\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(position, 0.0, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	Center_vec2 = glGetAttribLocation(program, "Center");
+	Radius_vec2 = glGetAttribLocation(program, "Radius");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+	Lean_float = glGetAttribLocation(program, "Lean");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+InstancedRectProgram::~InstancedRectProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
+
+void InstancedRectProgram::bind_rects(GLuint buffer, size_t first) const {
+	//set 'buffer' as the source of glVertexAttribPointer() commands:
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	GLbyte *base = (GLbyte *)0 + first * sizeof(Rect);
+
+	glVertexAttribPointer(Center_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Rect), base + 0);
+	glEnableVertexAttribArray(Center_vec2);
+
+	glVertexAttribPointer(Radius_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Rect), base + 4*2);
+	glEnableVertexAttribArray(Radius_vec2);
+
+	glVertexAttribPointer(Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Rect), base + 4*2 + 4*2);
+	glEnableVertexAttribArray(Color_vec4);
+
+	glVertexAttribPointer(Lean_float, 1, GL_FLOAT, GL_FALSE, sizeof(Rect), base + 4*2 + 4*2 + 1*4);
+	glEnableVertexAttribArray(Lean_float);
+
+	//each attribute advances once per instance (rectangle), not per vertex:
+	glVertexAttribDivisor(Center_vec2, 1);
+	glVertexAttribDivisor(Radius_vec2, 1);
+	glVertexAttribDivisor(Color_vec4, 1);
+	glVertexAttribDivisor(Lean_float, 1);
+
+	//done referring to the buffer, so unbind it:
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
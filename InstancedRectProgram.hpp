@@ -0,0 +1,44 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+//Shader program that draws colored rectangles (optionally "leaning"), one instance per rectangle:
+// the six vertices of each rectangle's two triangles are made from gl_VertexID, so the only data
+// is one Rect per rectangle, read from an instance buffer. Draw with:
+//   glDrawArraysInstanced(GL_TRIANGLES, 0, 6, rect_count);
+struct InstancedRectProgram {
+	InstancedRectProgram();
+	~InstancedRectProgram();
+
+	//per-instance data:
+	struct Rect {
+		Rect(glm::vec2 const &Center_, glm::vec2 const &Radius_, glm::u8vec4 const &Color_, float Lean_) :
+			Center(Center_), Radius(Radius_), Color(Color_), Lean(Lean_) { }
+		glm::vec2 Center;
+		glm::vec2 Radius;
+		glm::u8vec4 Color;
+		//displaces the top corners to make the rectangle point left or right:
+		// lean > 0 moves the top right corner up and right by lean, lean < 0 moves the top left corner up and left by -lean
+		float Lean;
+	};
+	static_assert(sizeof(Rect) == 4*2 + 4*2 + 1*4 + 4, "InstancedRectProgram::Rect should be packed");
+
+	//point the current vertex array object's attributes at the Rects in 'buffer', starting from Rect 'first':
+	// (with GL 3.3 there is no base instance for glDrawArraysInstanced, so drawing a range of a buffer means calling this again)
+	void bind_rects(GLuint buffer, size_t first = 0) const;
+
+	GLuint program = 0;
+
+	//Attribute (per-instance variable) locations:
+	GLuint Center_vec2 = -1U;
+	GLuint Radius_vec2 = -1U;
+	GLuint Color_vec4 = -1U;
+	GLuint Lean_float = -1U;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+};
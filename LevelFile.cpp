@@ -0,0 +1,201 @@
+#include "LevelFile.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//magic number as read on a machine with the other byte order:
+static constexpr uint32_t SwappedMagic = 0x424c564c;
+
+std::shared_ptr< LevelFile const > LevelFile::open(std::string const &filename) {
+	std::shared_ptr< LevelFile > file = std::make_shared< LevelFile >();
+
+	//----- map the whole file, read-only -----
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open level file '" + filename + "'.");
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || uint64_t(file_size.QuadPart) < sizeof(Header)) {
+		CloseHandle(handle);
+		throw std::runtime_error("'" + filename + "' is not a level file.");
+	}
+	HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping) {
+		file->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		//(the view keeps the mapping open, so neither handle is needed after this)
+		CloseHandle(mapping);
+	}
+	CloseHandle(handle);
+	if (!file->data) {
+		throw std::runtime_error("Failed to map level file '" + filename + "'.");
+	}
+	file->size = size_t(file_size.QuadPart);
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open level file '" + filename + "'.");
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || uint64_t(info.st_size) < sizeof(Header)) {
+		close(fd);
+		throw std::runtime_error("'" + filename + "' is not a level file.");
+	}
+	void *mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	//(the mapping keeps the file open, so the descriptor isn't needed after this)
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		throw std::runtime_error("Failed to map level file '" + filename + "'.");
+	}
+	file->data = mapped;
+	file->size = size_t(info.st_size);
+#endif
+
+	//----- check the header (the file is unmapped by ~LevelFile if this throws) -----
+	Header const &header = file->header();
+	if (header.magic == SwappedMagic) {
+		throw std::runtime_error("Level file '" + filename + "' was written on a machine with a different byte order.");
+	}
+	if (header.magic != Magic) {
+		throw std::runtime_error("'" + filename + "' is not a level file.");
+	}
+	if (header.version != Version) {
+		throw std::runtime_error("Level file '" + filename + "' is version " + std::to_string(header.version) + ", but this build reads version " + std::to_string(Version) + "; convert it again.");
+	}
+	if (header.file_size != file->size) {
+		throw std::runtime_error("Level file '" + filename + "' is truncated.");
+	}
+
+	size_t const element_size[SectionCount] = {
+		sizeof(Box), sizeof(Box), sizeof(Box), sizeof(Box),
+		sizeof(uint32_t), sizeof(uint32_t), sizeof(uint32_t),
+		sizeof(float), sizeof(float), sizeof(float), sizeof(float),
+	};
+	for (uint32_t s = 0; s < SectionCount; ++s) {
+		SectionInfo const &info = header.sections[s];
+		if (info.offset % Alignment != 0 || info.offset < sizeof(Header) || info.offset > file->size
+		 || info.count > (file->size - info.offset) / element_size[s]) {
+			throw std::runtime_error("Level file '" + filename + "' has a corrupt section table.");
+		}
+	}
+
+	//array sizes the collision code relies on:
+	uint64_t box_count = header.sections[Boxes].count;
+	uint64_t cell_count = uint64_t(header.grid_cells.x) * header.grid_cells.y;
+	bool grid_ok = (box_count == 0 || (cell_count > 0 && header.grid_cell_size > 0.0f && header.sections[CellStart].count == cell_count + 1));
+	bool soa_ok = true;
+	for (Section s : {MinX, MinY, MaxX, MaxY}) {
+		soa_ok = soa_ok && header.sections[s].count == box_count + BoxSoA::Lanes;
+	}
+	if (box_count > UINT32_MAX || !grid_ok || !soa_ok) {
+		throw std::runtime_error("Level file '" + filename + "' has inconsistent collision data.");
+	}
+
+	return file;
+}
+
+LevelFile::~LevelFile() {
+	if (!data) return;
+#if defined(_WIN32)
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast< void * >(data), size);
+#endif
+}
+
+void LevelFile::use_collision(BoxGrid *grid, BoxSoA *soa) const {
+	std::shared_ptr< void const > owner = shared_from_this();
+	Header const &h = header();
+	uint32_t box_count = uint32_t(h.sections[Boxes].count);
+
+	BoxGrid::Arrays grid_arrays;
+	grid_arrays.cell_start = section< uint32_t >(CellStart);
+	grid_arrays.cell_items = section< uint32_t >(CellItems);
+	grid_arrays.large_items = section< uint32_t >(LargeItems);
+	grid->use_prebuilt(box_count, h.grid_origin, h.grid_cell_size, h.grid_cells, grid_arrays, owner);
+
+	BoxSoA::Arrays soa_arrays;
+	soa_arrays.min_x = section< float >(MinX).data();
+	soa_arrays.min_y = section< float >(MinY).data();
+	soa_arrays.max_x = section< float >(MaxX).data();
+	soa_arrays.max_y = section< float >(MaxY).data();
+	soa->use_prebuilt(box_count, soa_arrays, owner);
+}
+
+void LevelFile::write(std::string const &filename, Contents const &contents) {
+	if (contents.boxes.size() > UINT32_MAX) {
+		throw std::runtime_error("Too many boxes for level file '" + filename + "'.");
+	}
+
+	//build the collision structures exactly as BouncSim::build_collision() would:
+	BoxGrid grid;
+	grid.build(contents.boxes, contents.cell_size);
+	BoxSoA soa;
+	soa.build(contents.boxes);
+
+	Header header;
+	header.ground_position = contents.ground.position;
+	header.ground_radius = contents.ground.radius;
+	header.grid_origin = grid.origin;
+	header.grid_cell_size = grid.cell_size;
+	header.grid_cells = grid.cells;
+
+	//lay out the sections one after another, each aligned:
+	struct Source {
+		void const *data;
+		size_t count;
+		size_t element_size;
+	};
+	Source const sources[SectionCount] = {
+		{ contents.boxes.data(), contents.boxes.size(), sizeof(Box) },
+		{ contents.stars.data(), contents.stars.size(), sizeof(Box) },
+		{ contents.shadow2_boxes.data(), contents.shadow2_boxes.size(), sizeof(Box) },
+		{ contents.shadow_boxes.data(), contents.shadow_boxes.size(), sizeof(Box) },
+		{ grid.cell_start.data(), grid.cell_start.size(), sizeof(uint32_t) },
+		{ grid.cell_items.data(), grid.cell_items.size(), sizeof(uint32_t) },
+		{ grid.large_items.data(), grid.large_items.size(), sizeof(uint32_t) },
+		{ soa.min_x.data(), soa.min_x.size(), sizeof(float) },
+		{ soa.min_y.data(), soa.min_y.size(), sizeof(float) },
+		{ soa.max_x.data(), soa.max_x.size(), sizeof(float) },
+		{ soa.max_y.data(), soa.max_y.size(), sizeof(float) },
+	};
+	auto align = [](uint64_t offset) {
+		return (offset + Alignment - 1) / Alignment * Alignment;
+	};
+	uint64_t offset = align(sizeof(Header));
+	for (uint32_t s = 0; s < SectionCount; ++s) {
+		header.sections[s].offset = offset;
+		header.sections[s].count = sources[s].count;
+		offset = align(offset + sources[s].count * sources[s].element_size);
+	}
+	header.file_size = offset;
+
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) {
+		throw std::runtime_error("Failed to open '" + filename + "' for writing a level.");
+	}
+	char const zeros[Alignment] = {0};
+	out.write(reinterpret_cast< char const * >(&header), sizeof(header));
+	uint64_t written = sizeof(header);
+	for (uint32_t s = 0; s < SectionCount; ++s) {
+		out.write(zeros, std::streamsize(header.sections[s].offset - written));
+		size_t bytes = sources[s].count * sources[s].element_size;
+		if (bytes) out.write(reinterpret_cast< char const * >(sources[s].data), std::streamsize(bytes));
+		written = header.sections[s].offset + bytes;
+	}
+	out.write(zeros, std::streamsize(header.file_size - written));
+	if (!out) {
+		throw std::runtime_error("Failed to write level file '" + filename + "'.");
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "BouncSim.hpp"
+#include "array_view.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * LevelFile is a B.O.U.N.C. level in a binary format that is used straight out of a memory-mapped file:
+ *  open() maps the file and checks its header and section sizes -- and that's all. The boxes, the scenery
+ *  layers, and the collision structures (a prebuilt BoxGrid and BoxSoA) are then read in place,
+ *  so even very large levels load in about the time it takes to map the file.
+ * Level files are made offline from a text description by 'bounc-level-convert' (see level_convert.cpp).
+ *
+ * File layout (host byte order, like InputRecording; a file from a machine with the other byte order
+ *  is detected by its magic number and rejected):
+ *   Header (below), then one array per Section, each starting at a multiple of Alignment bytes.
+ *   (Mappings start on a page boundary, so every array is aligned in memory as well.)
+ * The arrays' contents (e.g., the grid's box indices) are trusted, not checked, since checking them
+ *  would mean reading the whole file; write() is the only thing that should make these files.
+ */
+
+struct LevelFile : std::enable_shared_from_this< LevelFile > {
+	//NOTE: open will throw on error (missing file, not a level, wrong version, truncated):
+	static std::shared_ptr< LevelFile const > open(std::string const &filename);
+	LevelFile() = default;
+	LevelFile(LevelFile const &) = delete;
+	LevelFile &operator=(LevelFile const &) = delete;
+	~LevelFile();
+
+	typedef BouncSim::Box Box;
+
+	//----- format -----
+	static constexpr uint32_t Magic = 0x4c564c42; //"BLVL" as bytes on little-endian machines
+	static constexpr uint32_t Version = 1;
+	static constexpr uint32_t Alignment = 16;
+
+	enum Section : uint32_t {
+		//Box arrays (scenery layers back to front, as BouncMode draws them):
+		Boxes, Stars, Shadow2Boxes, ShadowBoxes,
+		//uint32_t arrays, the grid's (see BoxGrid.hpp):
+		CellStart, CellItems, LargeItems,
+		//float arrays, the boxes as BoxSoA stores them (Boxes + BoxSoA::Lanes entries each):
+		MinX, MinY, MaxX, MaxY,
+		SectionCount
+	};
+
+	struct SectionInfo {
+		uint64_t offset = 0; //from the start of the file
+		uint64_t count = 0; //elements, not bytes
+	};
+
+	struct Header {
+		uint32_t magic = Magic;
+		uint32_t version = Version;
+		uint64_t file_size = 0;
+		glm::vec2 ground_position = glm::vec2(0.0f);
+		glm::vec2 ground_radius = glm::vec2(0.0f);
+		//grid layout (the grid's arrays are sections):
+		glm::vec2 grid_origin = glm::vec2(0.0f);
+		float grid_cell_size = 0.0f;
+		uint32_t reserved = 0;
+		glm::uvec2 grid_cells = glm::uvec2(0);
+		SectionInfo sections[SectionCount];
+	};
+	static_assert(sizeof(Header) == 56 + 16 * SectionCount, "LevelFile::Header should be packed");
+	static_assert(sizeof(Box) == 16, "BouncSim::Box should be four floats, as stored in level files");
+
+	//----- contents (all pointing into the mapped file) -----
+	Header const &header() const { return *reinterpret_cast< Header const * >(data); }
+
+	Box ground() const { return Box(header().ground_position, header().ground_radius); }
+	ArrayView< Box > boxes() const { return section< Box >(Boxes); }
+	ArrayView< Box > stars() const { return section< Box >(Stars); }
+	ArrayView< Box > shadow2_boxes() const { return section< Box >(Shadow2Boxes); }
+	ArrayView< Box > shadow_boxes() const { return section< Box >(ShadowBoxes); }
+
+	//point a grid and SoA at this file's prebuilt ones, which they use in place
+	// (they keep a reference to this file, so it stays mapped for as long as they use it):
+	void use_collision(BoxGrid *grid, BoxSoA *soa) const;
+
+	//----- writing -----
+	//everything that goes in a level file (the collision structures are built from 'boxes'):
+	struct Contents {
+		Box ground = Box(glm::vec2(0.0f, -7.0f), glm::vec2(10.0f, 1.0f));
+		std::vector< Box > boxes;
+		std::vector< Box > stars, shadow2_boxes, shadow_boxes;
+		float cell_size = 0.0f; //grid cell size (zero picks one from the boxes, as BoxGrid::build does)
+	};
+	//NOTE: write will throw on error:
+	static void write(std::string const &filename, Contents const &contents);
+
+	//----- internals -----
+	template< typename T >
+	ArrayView< T > section(Section s) const {
+		SectionInfo const &info = header().sections[s];
+		return ArrayView< T >(reinterpret_cast< T const * >(reinterpret_cast< char const * >(data) + info.offset), size_t(info.count));
+	}
+
+	//the mapping:
+	void const *data = nullptr;
+	size_t size = 0;
+};
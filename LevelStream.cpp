@@ -0,0 +1,252 @@
+#include "LevelStream.hpp"
+
+#include "hash_fnv1a.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+//std::seed_seq's algorithm (as the standard specifies it) for exactly two seed values,
+// without the heap-allocated copy of them that std::seed_seq keeps:
+// (so chunks come out exactly as they did when seeded with std::seed_seq{ a, b })
+struct SeedSeq2 {
+	typedef uint32_t result_type;
+	uint32_t v[2];
+
+	template< typename It >
+	void generate(It begin, It end) const {
+		if (begin == end) return;
+		size_t const n = size_t(end - begin);
+		size_t const s = 2;
+		std::fill(begin, end, 0x8b8b8b8bu);
+		size_t const t = (n >= 623 ? 11 : n >= 68 ? 7 : n >= 39 ? 5 : n >= 7 ? 3 : (n - 1) / 2);
+		size_t const p = (n - t) / 2;
+		size_t const q = p + t;
+		size_t const m = std::max(s + 1, n);
+		auto T = [](uint32_t x) { return x ^ (x >> 27); };
+		for (size_t k = 0; k < m; ++k) {
+			uint32_t r1 = 1664525u * T(uint32_t(begin[k % n] ^ begin[(k + p) % n] ^ begin[(k + n - 1) % n]));
+			uint32_t r2 = r1 + uint32_t(k == 0 ? s : k <= s ? k % n + v[k - 1] : k % n);
+			begin[(k + p) % n] = uint32_t(begin[(k + p) % n] + r1);
+			begin[(k + q) % n] = uint32_t(begin[(k + q) % n] + r2);
+			begin[k % n] = r2;
+		}
+		for (size_t k = m; k < m + n; ++k) {
+			uint32_t r3 = 1566083941u * T(uint32_t(begin[k % n] + begin[(k + p) % n] + begin[(k + n - 1) % n]));
+			uint32_t r4 = r3 - uint32_t(k % n);
+			begin[(k + p) % n] = uint32_t(begin[(k + p) % n] ^ r3);
+			begin[(k + q) % n] = uint32_t(begin[(k + q) % n] ^ r4);
+			begin[k % n] = r4;
+		}
+	}
+};
+
+} //namespace
+
+LevelStream::LevelStream(uint64_t seed_, bool use_worker) : seed(seed_) {
+	requested.reserve(Slots);
+	finished.reserve(Slots);
+	arrived.reserve(Slots);
+	pending.reserve(Slots);
+	//(a chunk is either resident, spare, or with the worker, so Slots spares is always enough room)
+	spares.reserve(Slots);
+	if (use_worker) {
+		worker = std::thread(&LevelStream::worker_loop, this);
+	}
+}
+
+LevelStream::~LevelStream() {
+	if (worker.joinable()) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			quit = true;
+		}
+		work_ready.notify_one();
+		worker.join();
+	}
+}
+
+int32_t LevelStream::chunk_of(float x) {
+	return int32_t(std::floor((x + 0.5f * ChunkWidth) / ChunkWidth));
+}
+
+uint32_t LevelStream::slot_of(int32_t index) {
+	int32_t slot = index % int32_t(Slots);
+	return uint32_t(slot < 0 ? slot + int32_t(Slots) : slot);
+}
+
+void LevelStream::generate(uint64_t seed, int32_t index, LevelChunk *chunk) {
+	chunk->index = index;
+	chunk->boxes.clear();
+	chunk->shadow2_boxes.clear();
+	chunk->shadow_boxes.clear();
+
+	//every chunk gets its own generator, seeded from the world seed and the chunk index:
+	uint64_t hash = fnv1a(fnv1a(FNV1A_OFFSET, seed), index);
+	SeedSeq2 seq{{ uint32_t(hash), uint32_t(hash >> 32) }};
+	std::mt19937 mt(seq);
+	auto random = [&mt]() { return mt() / float(mt.max()); };
+
+	float left = index * ChunkWidth - 0.5f * ChunkWidth;
+
+	//pillars standing on y = -6 (like the original court's), a jumpable distance apart:
+	if (index == 0) {
+		BouncSim::court_boxes(&chunk->boxes);
+	} else {
+		float x = left + 1.0f + random();
+		while (x < left + ChunkWidth - 0.5f) {
+			float top = -1.5f + 3.0f * random();
+			float bottom = -6.0f;
+			chunk->boxes.emplace_back(glm::vec2(x, 0.5f * (top + bottom)), glm::vec2(0.6f, 0.5f * (top - bottom)));
+			x += 3.0f + 1.5f * random();
+		}
+	}
+
+	//scenery, as BouncMode generates it for the original court:
+	// (stars are drawn by BouncMode's sky pass, which covers every chunk already)
+	for (uint32_t i = 0; i < 20; ++i) {
+		float x = left + random() * ChunkWidth;
+		float w = random() * 2.0f;
+		float h = random() * 3.0f;
+		chunk->shadow_boxes.emplace_back(glm::vec2(x, -3.0f + (h - 3.0f)), glm::vec2(w, h));
+	}
+	for (uint32_t i = 0; i < 20; ++i) {
+		float x = left + random() * ChunkWidth;
+		float w = random() * 2.0f;
+		float h = random() * 5.0f;
+		chunk->shadow2_boxes.emplace_back(glm::vec2(x, -3.0f + (h - 3.0f)), glm::vec2(w, h));
+	}
+
+	chunk->ready = true;
+}
+
+LevelChunk const *LevelStream::chunk(int32_t index) const {
+	LevelChunk const &c = slots[slot_of(index)];
+	return (c.ready && c.index == index ? &c : nullptr);
+}
+
+bool LevelStream::update(float focus_x) {
+	int32_t new_center = chunk_of(focus_x);
+	bool changed = (new_center != center || version == 0);
+	center = new_center;
+
+	//pick up chunks the worker finished:
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		worker_center = center;
+		arrived.swap(finished);
+	}
+	for (auto &c : arrived) {
+		pending.erase(std::remove(pending.begin(), pending.end(), c.index), pending.end());
+		if (in_window(c.index) && !chunk(c.index)) {
+			std::swap(slots[slot_of(c.index)], c);
+		}
+	}
+
+	//evict chunks that fell out of the window:
+	// (emptied, but their storage is kept for the next chunk generated in that slot)
+	for (auto &c : slots) {
+		if (c.ready && !in_window(c.index)) {
+			recycle(&c);
+		}
+	}
+
+	//whatever was swapped out of the slots (or arrived too late) goes back to the worker to generate into:
+	if (!arrived.empty()) {
+		for (auto &c : arrived) {
+			recycle(&c);
+		}
+		std::unique_lock< std::mutex > lock(mutex);
+		for (auto &c : arrived) {
+			spares.emplace_back(std::move(c));
+		}
+	}
+	arrived.clear();
+	pending.erase(std::remove_if(pending.begin(), pending.end(), [this](int32_t index){ return !in_window(index); }), pending.end());
+
+	//near chunks are needed now; generate any the worker hasn't gotten to:
+	// (normally only at the start, or after a jump of more than a chunk, thanks to the catching up below)
+	for (int32_t index = center - Near; index <= center + Near; ++index) {
+		if (!chunk(index)) generate(seed, index, &slots[slot_of(index)]);
+	}
+
+	//catch up on the rest of the window a chunk at a time: if the worker still hasn't delivered a chunk
+	// requested on an earlier update (or there is no worker), generate the nearest one here, so that
+	// moving on into it doesn't have to generate it all at once along with everything else that changes then:
+	// (if the worker's copy shows up later, it is just recycled)
+	auto catch_up = [this]() {
+		for (int32_t offset = Near + 1; offset <= Prefetch; ++offset) {
+			for (int32_t index : {center + offset, center - offset}) {
+				if (chunk(index)) continue;
+				if (worker.joinable() && std::find(pending.begin(), pending.end(), index) == pending.end()) continue;
+				generate(seed, index, &slots[slot_of(index)]);
+				return;
+			}
+		}
+	};
+	catch_up();
+
+	//queue the rest of the window for the worker, nearest first:
+	if (worker.joinable()) {
+		bool queued = false;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			for (int32_t offset = Near + 1; offset <= Prefetch; ++offset) {
+				for (int32_t index : {center + offset, center - offset}) {
+					if (chunk(index) || std::find(pending.begin(), pending.end(), index) != pending.end()) continue;
+					pending.emplace_back(index);
+					requested.emplace_back(index);
+					queued = true;
+				}
+			}
+		}
+		if (queued) work_ready.notify_one();
+	}
+
+	if (changed) version += 1;
+	return changed;
+}
+
+void LevelStream::recycle(LevelChunk *chunk) {
+	chunk->ready = false;
+	chunk->boxes.clear();
+	chunk->shadow2_boxes.clear();
+	chunk->shadow_boxes.clear();
+}
+
+void LevelStream::near_boxes(std::vector< BouncSim::Box > *boxes) const {
+	boxes->clear();
+	for (int32_t index = center - Near; index <= center + Near; ++index) {
+		LevelChunk const *c = chunk(index);
+		if (c) boxes->insert(boxes->end(), c->boxes.begin(), c->boxes.end());
+	}
+}
+
+void LevelStream::worker_loop() {
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		work_ready.wait(lock, [this](){ return !requested.empty() || quit; });
+		if (quit) break;
+
+		//(oldest request first, since update() queues nearest chunks first)
+		int32_t index = requested.front();
+		requested.erase(requested.begin());
+		//skip requests the player has since moved away from:
+		if (index < worker_center - Prefetch || index > worker_center + Prefetch) continue;
+
+		//(generate into a spare chunk's storage, if there is one, so this doesn't allocate once warmed up)
+		LevelChunk c;
+		if (!spares.empty()) {
+			c = std::move(spares.back());
+			spares.pop_back();
+		}
+
+		lock.unlock();
+		generate(seed, index, &c);
+		lock.lock();
+
+		finished.emplace_back(std::move(c));
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "BouncSim.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * LevelStream makes an endless B.O.U.N.C. level out of procedurally generated chunks.
+ *
+ * The world is split along x into chunks ChunkWidth wide; chunk 0 is the original court
+ *  (centered on x = 0, with the original hand-made boxes), and every other chunk is generated
+ *  from a seed derived from its index alone, so a chunk always comes out the same.
+ *
+ * Around the chunk holding the focus (the player):
+ *  - chunks within Near are "near": they are always resident after update() (generated right away
+ *    if they aren't ready), and they are the only chunks collision uses, so the simulation doesn't
+ *    depend on how fast the worker thread happens to be;
+ *  - chunks within Prefetch are generated ahead of time on a worker thread (if it falls behind,
+ *    update() catches up by generating one of them itself, so no update ever has to make more than one);
+ *  - anything further away is evicted.
+ * At most Slots chunks are ever resident, so memory and per-frame cost stay the same however far the player goes;
+ *  evicted chunks keep their storage and are handed back to the worker to generate into, so once warmed up,
+ *  streaming doesn't allocate.
+ */
+
+struct LevelChunk {
+	int32_t index = 0;
+	bool ready = false;
+	//collision boxes:
+	std::vector< BouncSim::Box > boxes;
+	//scenery layers (drawn only), back to front:
+	std::vector< BouncSim::Box > shadow2_boxes;
+	std::vector< BouncSim::Box > shadow_boxes;
+};
+
+struct LevelStream {
+	explicit LevelStream(uint64_t seed, bool use_worker = true);
+	~LevelStream();
+
+	static constexpr float ChunkWidth = 20.0f;
+	static constexpr int32_t Near = 1;
+	static constexpr int32_t Prefetch = 2;
+	static constexpr uint32_t Slots = 2 * Prefetch + 1;
+
+	//index of the chunk holding x:
+	static int32_t chunk_of(float x);
+
+	//build chunk 'index' of the world with seed 'seed' (what the worker runs):
+	static void generate(uint64_t seed, int32_t index, LevelChunk *chunk);
+
+	//move the window to be around 'focus_x'; returns true if the near chunks changed:
+	bool update(float focus_x);
+
+	//chunk at the center of the window, as of the last update():
+	int32_t center = 0;
+	//incremented whenever the near chunks change:
+	uint64_t version = 0;
+
+	//resident chunk 'index' (nullptr if it isn't; near chunks always are):
+	LevelChunk const *chunk(int32_t index) const;
+
+	//collision boxes of all near chunks (left to right):
+	void near_boxes(std::vector< BouncSim::Box > *boxes) const;
+
+	uint64_t const seed;
+
+	//----- internals -----
+	//chunk 'index' lives in slot index mod Slots:
+	static uint32_t slot_of(int32_t index);
+	std::array< LevelChunk, Slots > slots;
+
+	//background generation:
+	void worker_loop();
+	bool in_window(int32_t index) const { return index >= center - Prefetch && index <= center + Prefetch; }
+	std::vector< int32_t > pending; //chunks requested from the worker and not yet picked up
+	std::vector< LevelChunk > arrived; //(scratch for update(), so picking up chunks doesn't allocate)
+	//empty a chunk that is no longer needed, keeping its storage:
+	static void recycle(LevelChunk *chunk);
+
+	//shared with the worker:
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::vector< int32_t > requested; //chunks the worker should generate (at most Slots)
+	std::vector< LevelChunk > finished; //chunks the worker has generated, waiting for update()
+	std::vector< LevelChunk > spares; //emptied chunks (with their storage) for the worker to generate into
+	int32_t worker_center = 0; //copy of 'center' for the worker (to skip stale requests)
+	bool quit = false;
+	std::thread worker;
+};
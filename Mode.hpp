@@ -13,12 +13,27 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	//The function should return 'true' if it handled the event.
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) { return false; }
 
-	//update is called at the start of a new frame, after events are handled:
-	// 'elapsed' is time in seconds since the last call to 'update'
+	//update is called at a fixed rate (see 'tick_rate' in main.cpp), after events are handled:
+	// 'elapsed' is the (constant) length of a tick in seconds
+	// (note that this might be many times per frame or never)
 	virtual void update(float elapsed) { }
 
-	//draw is called after update:
-	virtual void draw(glm::uvec2 const &drawable_size) = 0;
+	//sync is called once per frame after any updates, while no handle_event or update call is running:
+	// copy whatever draw() and needs_redraw() read out of the state that handle_event() and update() write.
+	// After sync, draw() may run on a different thread at the same time as the next frame's
+	// handle_event()/update() calls (see SimThread.hpp), so it must only read the copied state.
+	virtual void sync() { }
+
+	//draw is called once per frame, after sync:
+	// 'alpha' in [0,1) is how far the current time is between the most recent update and the next one,
+	// so positions can be interpolated between the previous and current update
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) = 0;
+
+	//needs_redraw is called once per frame, after sync:
+	// return 'false' if draw() would produce exactly the same image as it did last time
+	// (main then skips drawing and swapping, and waits for input instead of spinning at vsync rate)
+	// (resizes, overlays, and screenshots force a redraw regardless)
+	virtual bool needs_redraw() const { return true; }
 
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
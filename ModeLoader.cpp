@@ -0,0 +1,114 @@
+#include "ModeLoader.hpp"
+
+#include "GL.hpp"
+#include "gl_errors.hpp"
+#include "profile_zones.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+ModeLoader::ModeLoader(SDL_Window *window_) : window(window_) {
+	SDL_GLContext main_context = SDL_GL_GetCurrentContext();
+	if (!main_context) {
+		throw std::runtime_error("ModeLoader needs the main OpenGL context to be current.");
+	}
+
+	//contexts are created on the main thread (some platforms insist) and then handed to the loader thread:
+	// (creating a context also makes it current, so switch back to the main one afterward)
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	context = SDL_GL_CreateContext(window);
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+	SDL_GL_MakeCurrent(window, main_context);
+
+	if (!context) {
+		throw std::runtime_error(std::string("Error creating loader OpenGL context: ") + SDL_GetError());
+	}
+
+	thread = std::thread(&ModeLoader::thread_loop, this);
+}
+
+ModeLoader::~ModeLoader() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	job_ready.notify_one();
+	thread.join();
+
+	//(a Mode that was never taken is freed here, with the main context current)
+	result.reset();
+
+	SDL_GL_DeleteContext(context);
+	context = nullptr;
+}
+
+void ModeLoader::load(std::function< std::shared_ptr< Mode >() > const &make) {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		job = make;
+	}
+	job_ready.notify_one();
+}
+
+std::shared_ptr< Mode > ModeLoader::take() {
+	std::unique_lock< std::mutex > lock(mutex);
+	if (error) {
+		std::exception_ptr e = error;
+		error = nullptr;
+		std::rethrow_exception(e);
+	}
+	std::shared_ptr< Mode > ret = result;
+	result.reset();
+	return ret;
+}
+
+bool ModeLoader::loading() {
+	std::unique_lock< std::mutex > lock(mutex);
+	return job || running;
+}
+
+void ModeLoader::thread_loop() {
+	if (SDL_GL_MakeCurrent(window, context) != 0) {
+		std::cerr << "ModeLoader couldn't make its context current (" << SDL_GetError() << ")." << std::endl;
+	}
+
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		job_ready.wait(lock, [this](){ return quit || job; });
+		if (quit) break;
+
+		std::function< std::shared_ptr< Mode >() > make;
+		std::swap(make, job);
+		running = true;
+		lock.unlock();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::shared_ptr< Mode > mode;
+		std::exception_ptr e;
+		try {
+			PROFILE_ZONE("ModeLoader::load");
+			mode = make();
+			//make sure every upload has actually happened before another context uses the objects:
+			glFinish();
+			GL_ERRORS();
+		} catch (...) {
+			e = std::current_exception();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		lock.lock();
+		running = false;
+		last_load_ms = std::chrono::duration< float, std::milli >(end - start).count();
+		if (e) {
+			error = e;
+		} else {
+			//(replaces any result that wasn't taken; never-drawn Modes only own shared objects,
+			// so freeing one here, with the loader context current, is fine)
+			result = mode;
+		}
+	}
+
+	SDL_GL_MakeCurrent(window, nullptr);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Mode.hpp"
+
+#include <SDL.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/*
+ * ModeLoader constructs Modes on a background thread, with an OpenGL context that
+ *  shares objects (buffers, textures, programs) with the main one, so building the
+ *  next Mode doesn't stall drawing. Once it is ready, swap it in with Mode::set_current.
+ *
+ * Not everything is shared between contexts: vertex array objects (and framebuffer objects)
+ *  belong to the context that made them, so Modes must create those on first draw instead.
+ *
+ * Usage:
+ *   loader.load([](){ return std::make_shared< BouncMode >(); });
+ *   ...each frame...
+ *   if (auto mode = loader.take()) Mode::set_current(mode);
+ */
+
+struct ModeLoader {
+	//create the loader's context; call with 'window's main context current (it stays current):
+	explicit ModeLoader(SDL_Window *window);
+	~ModeLoader(); //waits for any load in progress
+
+	//start constructing a Mode on the loader thread (replaces any not-yet-taken result):
+	void load(std::function< std::shared_ptr< Mode >() > const &make);
+
+	//if a load has finished, return its Mode (once); otherwise return null:
+	//NOTE: rethrows any exception thrown by the Mode's constructor
+	std::shared_ptr< Mode > take();
+
+	//is a load queued or running?
+	bool loading();
+
+	//----- internals -----
+	void thread_loop();
+
+	SDL_Window *window = nullptr;
+	SDL_GLContext context = nullptr;
+
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	bool quit = false;
+	std::function< std::shared_ptr< Mode >() > job; //load to run (empty if none)
+	bool running = false; //a job is being run
+	std::shared_ptr< Mode > result; //finished Mode, waiting to be taken
+	std::exception_ptr error; //...or the exception that prevented it
+	std::atomic< float > last_load_ms{0.0f}; //how long the last load took on the loader thread
+
+	std::thread thread;
+};
@@ -0,0 +1,109 @@
+#include "PngWriter.hpp"
+
+#include "profile_zones.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+PngWriter::PngWriter(uint32_t workers_, size_t max_queued_, Overflow overflow_) : max_queued(max_queued_), overflow(overflow_) {
+	workers_ = std::max(workers_, 1U);
+	for (uint32_t i = 0; i < workers_; ++i) {
+		workers.emplace_back(&PngWriter::worker_loop, this);
+	}
+}
+
+PngWriter::~PngWriter() {
+	{
+		std::lock_guard< std::mutex > lock(mutex);
+		quit = true;
+	}
+	job_ready.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+bool PngWriter::reserve() {
+	std::unique_lock< std::mutex > lock(mutex);
+	if (max_queued != 0 && jobs.size() + reserved >= max_queued) {
+		if (overflow == Overflow::Drop) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		PROFILE_ZONE("PngWriter backpressure");
+		space_ready.wait(lock, [this](){ return jobs.size() + reserved < max_queued; });
+	}
+	reserved += 1;
+	return true;
+}
+
+void PngWriter::unreserve() {
+	{
+		std::lock_guard< std::mutex > lock(mutex);
+		assert(reserved > 0);
+		reserved -= 1;
+	}
+	space_ready.notify_one();
+}
+
+std::vector< glm::u8vec4 > PngWriter::take_buffer() {
+	std::vector< glm::u8vec4 > buffer;
+	std::lock_guard< std::mutex > lock(mutex);
+	if (!spare_buffers.empty()) {
+		buffer.swap(spare_buffers.back());
+		spare_buffers.pop_back();
+	}
+	return buffer;
+}
+
+bool PngWriter::enqueue(Job &&job, bool was_reserved) {
+	if (!was_reserved && !reserve()) return false;
+	{
+		std::lock_guard< std::mutex > lock(mutex);
+		assert(reserved > 0);
+		reserved -= 1;
+		jobs.emplace_back(std::move(job));
+		if (jobs.size() > max_depth.load(std::memory_order_relaxed)) {
+			max_depth.store(jobs.size(), std::memory_order_relaxed);
+		}
+	}
+	job_ready.notify_one();
+	return true;
+}
+
+size_t PngWriter::queue_depth() {
+	std::lock_guard< std::mutex > lock(mutex);
+	return jobs.size();
+}
+
+void PngWriter::worker_loop() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			job_ready.wait(lock, [this](){ return quit || !jobs.empty(); });
+			//only stop once everything queued has been written:
+			if (jobs.empty()) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		space_ready.notify_one();
+
+		PROFILE_ZONE("PngWriter job");
+		if (job.force_opaque) {
+			for (auto &px : job.data) {
+				px.a = 0xff;
+			}
+		}
+		save_png(job.filename, job.size, job.data.data(), job.origin);
+		written.fetch_add(1, std::memory_order_relaxed);
+
+		//keep the pixel storage around for take_buffer()
+		// (enough for a full queue plus one image per worker; more would just be waiting memory):
+		std::lock_guard< std::mutex > lock(mutex);
+		if (spare_buffers.size() < std::max< size_t >(max_queued, 1) + workers.size()) {
+			spare_buffers.emplace_back(std::move(job.data));
+		}
+	}
+}
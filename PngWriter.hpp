@@ -0,0 +1,81 @@
+#pragma once
+
+#include "load_save_png.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * PngWriter encodes and saves PNG images on a pool of background threads,
+ *  so callers never wait on compression or file I/O.
+ * The queue of pending images can be bounded; when it is full, enqueue()
+ *  either drops the image (counted in 'dropped') or blocks until a worker
+ *  frees up space, depending on 'overflow'.
+ * Callers that have to do real work to fill in an image (e.g., copying a frame)
+ *  can reserve() its place in the queue first, and fill in a buffer from
+ *  take_buffer(), which recycles the pixels of images already written.
+ */
+
+struct PngWriter {
+	enum class Overflow {
+		Drop, //discard the new image (never blocks the caller)
+		Block, //wait for space (lossless, but applies backpressure to the caller)
+	};
+
+	//starts 'workers' threads; max_queued == 0 means the queue is unbounded:
+	explicit PngWriter(uint32_t workers = 1, size_t max_queued = 0, Overflow overflow = Overflow::Drop);
+	~PngWriter(); //finishes all queued images, then stops the workers
+
+	struct Job {
+		std::string filename;
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > data;
+		OriginLocation origin = LowerLeftOrigin;
+		bool force_opaque = false; //set alpha to 0xff before saving (for framebuffer readbacks)
+	};
+
+	//queue an image to be written; returns false if it was dropped:
+	// ('reserved' means reserve() already made room for it, so it is never dropped)
+	bool enqueue(Job &&job, bool reserved = false);
+
+	//make room for one image before preparing it; returns false (counting the image as dropped)
+	// if the queue is full and overflow is Drop, and waits for space if it is Block:
+	bool reserve();
+	//give back a reservation that won't be used after all:
+	void unreserve();
+
+	//a buffer for a Job's pixels; reuses the storage of written images when there is some:
+	std::vector< glm::u8vec4 > take_buffer();
+
+	//images waiting for a worker (not counting ones being encoded):
+	size_t queue_depth();
+
+	//----- configuration -----
+	size_t const max_queued;
+	Overflow const overflow;
+
+	//----- statistics -----
+	std::atomic< uint64_t > written{0};
+	std::atomic< uint64_t > dropped{0};
+	std::atomic< size_t > max_depth{0}; //deepest the queue has been
+
+	//----- internals -----
+	void worker_loop();
+
+	std::mutex mutex;
+	std::condition_variable job_ready; //signaled when a job is queued (or on quit)
+	std::condition_variable space_ready; //signaled when a job is taken off the queue
+	std::deque< Job > jobs; //guarded by mutex
+	size_t reserved = 0; //room promised by reserve(), guarded by mutex
+	std::vector< std::vector< glm::u8vec4 > > spare_buffers; //pixels of written jobs, for take_buffer(); guarded by mutex
+	bool quit = false; //guarded by mutex
+	std::vector< std::thread > workers;
+};
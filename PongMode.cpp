@@ -6,311 +6,128 @@
 //for glm::value_ptr() :
 #include <glm/gtc/type_ptr.hpp>
 
-#include <random>
+#include <array>
+#include <cassert>
+#include <new>
 
 PongMode::PongMode() {
-
-	//set up trail as if ball has been here for 'forever':
-	ball_trail.clear();
-	ball_trail.emplace_back(ball, trail_length);
-	ball_trail.emplace_back(ball, 0.0f);
-
-	
-	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
-
-	{ //vertex array mapping buffer for color_texture_program:
-		//ask OpenGL to fill vertex_buffer_for_color_texture_program with the name of an unused vertex array object:
-		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer_for_color_texture_program as the current vertex array object:
-		glBindVertexArray(vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-
-		//set up the vertex array object to describe arrays of PongMode::Vertex:
-		glVertexAttribPointer(
-			color_texture_program.Position_vec4, //attribute
-			3, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 0 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Position_vec4);
-		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
-
-		glVertexAttribPointer(
-			color_texture_program.Color_vec4, //attribute
-			4, //size
-			GL_UNSIGNED_BYTE, //type
-			GL_TRUE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Color_vec4);
-
-		glVertexAttribPointer(
-			color_texture_program.TexCoord_vec2, //attribute
-			2, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 + 4*1 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
-
-		//done referring to vertex_buffer, so unbind it:
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		//done setting up vertex array object, so unbind it:
-		glBindVertexArray(0);
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
-
-	{ //solid white texture:
-		//ask OpenGL to fill white_tex with the name of an unused texture object:
-		glGenTextures(1, &white_tex);
-
-		//bind that texture object as a GL_TEXTURE_2D-type texture:
-		glBindTexture(GL_TEXTURE_2D, white_tex);
-
-		//upload a 1x1 image of solid white to the texture:
-		glm::uvec2 size = glm::uvec2(1,1);
-		std::vector< glm::u8vec4 > data(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-
-		//set filtering and wrapping parameters:
-		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		//since texture uses a mipmap and we haven't uploaded one, instruct opengl to make one for us:
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		//Okay, texture uploaded, can unbind it:
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
+	//(OpenGL resources are all made by members: rect_program, rect_stream)
 }
 
 PongMode::~PongMode() {
 
 	//----- free OpenGL resources -----
-	glDeleteBuffers(1, &vertex_buffer);
-	vertex_buffer = 0;
-
-	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
-	vertex_buffer_for_color_texture_program = 0;
-
-	glDeleteTextures(1, &white_tex);
-	white_tex = 0;
-}
-
-bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
-
-	if (evt.type == SDL_MOUSEMOTION) {
-		//convert mouse from window pixels (top-left origin, +y is down) to clip space ([-1,1]x[-1,1], +y is up):
-		glm::vec2 clip_mouse = glm::vec2(
-			(evt.motion.x + 0.5f) / window_size.x * 2.0f - 1.0f,
-			(evt.motion.y + 0.5f) / window_size.y *-2.0f + 1.0f
-		);
-		left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
-	}
-
-	return false;
+	glDeleteVertexArrays(1, &rect_stream_for_rect_program);
+	rect_stream_for_rect_program = 0;
 }
 
-void PongMode::update(float elapsed) {
-
-	static std::mt19937 mt; //mersenne twister pseudo-random number generator
-
-	//----- paddle update -----
-
-	{ //right player ai:
-		ai_offset_update -= elapsed;
-		if (ai_offset_update < elapsed) {
-			//update again in [0.5,1.0) seconds:
-			ai_offset_update = (mt() / float(mt.max())) * 0.5f + 0.5f;
-			ai_offset = (mt() / float(mt.max())) * 2.5f - 1.25f;
-		}
-		if (right_paddle.y < ball.y + ai_offset) {
-			right_paddle.y = std::min(ball.y + ai_offset, right_paddle.y + 2.0f * elapsed);
-		} else {
-			right_paddle.y = std::max(ball.y + ai_offset, right_paddle.y - 2.0f * elapsed);
-		}
-	}
-
-	//clamp paddles to court:
-	right_paddle.y = std::max(right_paddle.y, -court_radius.y + paddle_radius.y);
-	right_paddle.y = std::min(right_paddle.y,  court_radius.y - paddle_radius.y);
-
-	left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
-	left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
+void PongMode::create_vertex_array() {
+	//vertex array mapping buffer for rect_program:
+	// (vertex array objects aren't shared between OpenGL contexts, so this happens on first draw,
+	//  on the main context, rather than in the constructor, which may run on a ModeLoader thread)
 
-	//----- ball update -----
+	//ask OpenGL to fill rect_stream_for_rect_program with the name of an unused vertex array object:
+	glGenVertexArrays(1, &rect_stream_for_rect_program);
 
-	//speed of ball doubles every four points:
-	float speed_multiplier = 4.0f * std::pow(2.0f, (left_score + right_score) / 4.0f);
+	//set rect_stream_for_rect_program as the current vertex array object:
+	glBindVertexArray(rect_stream_for_rect_program);
 
-	//velocity cap, though (otherwise ball can pass through paddles):
-	speed_multiplier = std::min(speed_multiplier, 10.0f);
+	//set up the vertex array object to read InstancedRectProgram::Rects from rect_stream, one per instance:
+	// (draw() re-points it at wherever each frame's rectangles were written)
+	rect_program.bind_rects(rect_stream.buffer);
 
-	ball += elapsed * speed_multiplier * ball_velocity;
-
-	//---- collision handling ----
-
-	//paddles:
-	auto paddle_vs_ball = [this](glm::vec2 const &paddle) {
-		//compute area of overlap:
-		glm::vec2 min = glm::max(paddle - paddle_radius, ball - ball_radius);
-		glm::vec2 max = glm::min(paddle + paddle_radius, ball + ball_radius);
-
-		//if no overlap, no collision:
-		if (min.x > max.x || min.y > max.y) return;
-
-		if (max.x - min.x > max.y - min.y) {
-			//wider overlap in x => bounce in y direction:
-			if (ball.y > paddle.y) {
-				ball.y = paddle.y + paddle_radius.y + ball_radius.y;
-				ball_velocity.y = std::abs(ball_velocity.y);
-			} else {
-				ball.y = paddle.y - paddle_radius.y - ball_radius.y;
-				ball_velocity.y = -std::abs(ball_velocity.y);
-			}
-		} else {
-			//wider overlap in y => bounce in x direction:
-			if (ball.x > paddle.x) {
-				ball.x = paddle.x + paddle_radius.x + ball_radius.x;
-				ball_velocity.x = std::abs(ball_velocity.x);
-			} else {
-				ball.x = paddle.x - paddle_radius.x - ball_radius.x;
-				ball_velocity.x = -std::abs(ball_velocity.x);
-			}
-			//warp y velocity based on offset from paddle center:
-			float vel = (ball.y - paddle.y) / (paddle_radius.y + ball_radius.y);
-			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
-		}
-	};
-	paddle_vs_ball(left_paddle);
-	paddle_vs_ball(right_paddle);
-
-	//court walls:
-	if (ball.y > court_radius.y - ball_radius.y) {
-		ball.y = court_radius.y - ball_radius.y;
-		if (ball_velocity.y > 0.0f) {
-			ball_velocity.y = -ball_velocity.y;
-		}
-	}
-	if (ball.y < -court_radius.y + ball_radius.y) {
-		ball.y = -court_radius.y + ball_radius.y;
-		if (ball_velocity.y < 0.0f) {
-			ball_velocity.y = -ball_velocity.y;
-		}
-	}
+	//done setting up vertex array object, so unbind it:
+	glBindVertexArray(0);
 
-	if (ball.x > court_radius.x - ball_radius.x) {
-		ball.x = court_radius.x - ball_radius.x;
-		if (ball_velocity.x > 0.0f) {
-			ball_velocity.x = -ball_velocity.x;
-			left_score += 1;
-		}
-	}
-	if (ball.x < -court_radius.x + ball_radius.x) {
-		ball.x = -court_radius.x + ball_radius.x;
-		if (ball_velocity.x < 0.0f) {
-			ball_velocity.x = -ball_velocity.x;
-			right_score += 1;
-		}
-	}
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
 
-	//----- gradient trails -----
+bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	return sim.handle_event(evt, window_size);
+}
 
-	//age up all locations in ball trail:
-	for (auto &t : ball_trail) {
-		t.z += elapsed;
-	}
-	//store fresh location at back of ball trail:
-	ball_trail.emplace_back(ball, 0.0f);
+void PongMode::update(float elapsed) {
+	prev_right_paddle = sim.right_paddle;
+	prev_ball = sim.ball;
+	sim.update(elapsed);
+}
 
-	//trim any too-old locations from back of trail:
-	//NOTE: since trail drawing interpolates between points, only removes back element if second-to-back element is too old:
-	while (ball_trail.size() >= 2 && ball_trail[1].z > trail_length) {
-		ball_trail.pop_front();
-	}
+void PongMode::sync() {
+	drawing.left_paddle = sim.left_paddle;
+	drawing.right_paddle = sim.right_paddle;
+	drawing.prev_right_paddle = prev_right_paddle;
+	drawing.ball = sim.ball;
+	drawing.prev_ball = prev_ball;
+	drawing.left_score = sim.left_score;
+	drawing.right_score = sim.right_score;
+	drawing.ball_trail = sim.ball_trail;
 }
 
-void PongMode::draw(glm::uvec2 const &drawable_size) {
+void PongMode::draw(glm::uvec2 const &drawable_size, float alpha) {
+	if (rect_stream_for_rect_program == 0) create_vertex_array();
+
 	//some nice colors from the course web page:
 	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
 	const glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x193b59ff);
 	const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xf2d2b6ff);
 	const glm::u8vec4 shadow_color = HEX_TO_U8VEC4(0xf2ad94ff);
-	const std::vector< glm::u8vec4 > trail_colors = {
+	const std::array< glm::u8vec4, 3 > trail_colors = {{
 		HEX_TO_U8VEC4(0xf2ad9488),
 		HEX_TO_U8VEC4(0xf2897288),
 		HEX_TO_U8VEC4(0xbacac088),
-	};
+	}};
 	#undef HEX_TO_U8VEC4
 
 	//other useful drawing constants:
 	const float wall_radius = 0.05f;
 	const float shadow_offset = 0.07f;
-	const float padding = 0.14f; //padding between outside of walls and edge of window
 
-	//---- compute vertices to draw ----
+	//---- compute rectangles to draw ----
 
-	//vertices will be accumulated into this list and then uploaded+drawn at the end of this function:
-	std::vector< Vertex > vertices;
+	//rectangles will be written straight into rect_stream's mapped memory, then drawn at the end of this function:
+	// (room for the shadows, trail, walls, paddles, ball, and scores)
+	const size_t max_rects = 7 + 20 + 7 + drawing.left_score + drawing.right_score;
+	Rect *rects = rect_stream.map< Rect >(max_rects);
+	size_t rect_count = 0;
 
 	//inline helper function for rectangle drawing:
-	auto draw_rectangle = [&vertices](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	auto draw_rectangle = [rects, &rect_count, max_rects](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+		assert(rect_count < max_rects);
+		new (rects + rect_count) Rect(center, radius, color, 0.0f);
+		rect_count += 1;
 	};
 
+	//interpolate moving objects between the previous and current update:
+	// (the left paddle follows the mouse directly, so it is always current)
+	glm::vec2 right_paddle = glm::mix(drawing.prev_right_paddle, drawing.right_paddle, alpha);
+	glm::vec2 ball = glm::mix(drawing.prev_ball, drawing.ball, alpha);
+
 	//shadows for everything (except the trail):
 
 	glm::vec2 s = glm::vec2(0.0f,-shadow_offset);
 
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius)+s, glm::vec2(court_radius.x, wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius)+s, glm::vec2(court_radius.x, wall_radius), shadow_color);
-	draw_rectangle(left_paddle+s, paddle_radius, shadow_color);
-	draw_rectangle(right_paddle+s, paddle_radius, shadow_color);
-	draw_rectangle(ball+s, ball_radius, shadow_color);
+	draw_rectangle(glm::vec2(-sim.court_radius.x-wall_radius, 0.0f)+s, glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), shadow_color);
+	draw_rectangle(glm::vec2( sim.court_radius.x+wall_radius, 0.0f)+s, glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), shadow_color);
+	draw_rectangle(glm::vec2( 0.0f,-sim.court_radius.y-wall_radius)+s, glm::vec2(sim.court_radius.x, wall_radius), shadow_color);
+	draw_rectangle(glm::vec2( 0.0f, sim.court_radius.y+wall_radius)+s, glm::vec2(sim.court_radius.x, wall_radius), shadow_color);
+	draw_rectangle(drawing.left_paddle+s, sim.paddle_radius, shadow_color);
+	draw_rectangle(right_paddle+s, sim.paddle_radius, shadow_color);
+	draw_rectangle(ball+s, sim.ball_radius, shadow_color);
 
 	//ball's trail:
-	if (ball_trail.size() >= 2) {
+	if (drawing.ball_trail.size() >= 2) {
 		//start ti at second element so there is always something before it to interpolate from:
-		std::deque< glm::vec3 >::iterator ti = ball_trail.begin() + 1;
+		std::vector< glm::vec3 >::const_iterator ti = drawing.ball_trail.begin() + 1;
 		//draw trail from oldest-to-newest:
 		constexpr uint32_t STEPS = 20;
 		//draw from [STEPS, ..., 1]:
 		for (uint32_t step = STEPS; step > 0; --step) {
 			//time at which to draw the trail element:
-			float t = step / float(STEPS) * trail_length;
+			float t = step / float(STEPS) * sim.trail_length;
 			//advance ti until 'just before' t:
-			while (ti != ball_trail.end() && ti->z > t) ++ti;
+			while (ti != drawing.ball_trail.end() && ti->z > t) ++ti;
 			//if we ran out of recorded tail, stop drawing:
-			if (ti == ball_trail.end()) break;
+			if (ti == drawing.ball_trail.end()) break;
 			//interpolate between previous and current trail point to the correct time:
 			glm::vec3 a = *(ti-1);
 			glm::vec3 b = *(ti);
@@ -337,77 +154,42 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 			);
 
 			//draw:
-			draw_rectangle(at, ball_radius, color);
+			draw_rectangle(at, sim.ball_radius, color);
 		}
 	}
 
 	//solid objects:
 
 	//walls:
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
+	draw_rectangle(glm::vec2(-sim.court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), fg_color);
+	draw_rectangle(glm::vec2( sim.court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), fg_color);
+	draw_rectangle(glm::vec2( 0.0f,-sim.court_radius.y-wall_radius), glm::vec2(sim.court_radius.x, wall_radius), fg_color);
+	draw_rectangle(glm::vec2( 0.0f, sim.court_radius.y+wall_radius), glm::vec2(sim.court_radius.x, wall_radius), fg_color);
 
 	//paddles:
-	draw_rectangle(left_paddle, paddle_radius, fg_color);
-	draw_rectangle(right_paddle, paddle_radius, fg_color);
+	draw_rectangle(drawing.left_paddle, sim.paddle_radius, fg_color);
+	draw_rectangle(right_paddle, sim.paddle_radius, fg_color);
 	
 
 	//ball:
-	draw_rectangle(ball, ball_radius, fg_color);
+	draw_rectangle(ball, sim.ball_radius, fg_color);
 
 	//scores:
 	glm::vec2 score_radius = glm::vec2(0.1f, 0.1f);
-	for (uint32_t i = 0; i < left_score; ++i) {
-		draw_rectangle(glm::vec2( -court_radius.x + (2.0f + 3.0f * i) * score_radius.x, court_radius.y + 2.0f * wall_radius + 2.0f * score_radius.y), score_radius, fg_color);
+	for (uint32_t i = 0; i < drawing.left_score; ++i) {
+		draw_rectangle(glm::vec2( -sim.court_radius.x + (2.0f + 3.0f * i) * score_radius.x, sim.court_radius.y + 2.0f * wall_radius + 2.0f * score_radius.y), score_radius, fg_color);
 	}
-	for (uint32_t i = 0; i < right_score; ++i) {
-		draw_rectangle(glm::vec2( court_radius.x - (2.0f + 3.0f * i) * score_radius.x, court_radius.y + 2.0f * wall_radius + 2.0f * score_radius.y), score_radius, fg_color);
+	for (uint32_t i = 0; i < drawing.right_score; ++i) {
+		draw_rectangle(glm::vec2( sim.court_radius.x - (2.0f + 3.0f * i) * score_radius.x, sim.court_radius.y + 2.0f * wall_radius + 2.0f * score_radius.y), score_radius, fg_color);
 	}
 
 
 
 	//------ compute court-to-window transform ------
-
-	//compute area that should be visible:
-	glm::vec2 scene_min = glm::vec2(
-		-court_radius.x - 2.0f * wall_radius - padding,
-		-court_radius.y - 2.0f * wall_radius - padding
-	);
-	glm::vec2 scene_max = glm::vec2(
-		court_radius.x + 2.0f * wall_radius + padding,
-		court_radius.y + 2.0f * wall_radius + 3.0f * score_radius.y + padding
-	);
-
-	//compute window aspect ratio:
-	float aspect = drawable_size.x / float(drawable_size.y);
-	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
-
-	//compute scale factor for court given that...
-	float scale = std::min(
-		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
-		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
-	);
-
-	glm::vec2 center = 0.5f * (scene_max + scene_min);
-
-	//build matrix that scales and translates appropriately:
-	glm::mat4 court_to_clip = glm::mat4(
-		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, scale, 0.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-		glm::vec4(-center.x * (scale / aspect), -center.y * scale, 0.0f, 1.0f)
-	);
-	//NOTE: glm matrices are specified in *Column-Major* order,
-	// so each line above is specifying a *column* of the matrix(!)
-
-	//also build the matrix that takes clip coordinates to court coordinates (used for mouse handling):
-	clip_to_court = glm::mat3x2(
-		glm::vec2(aspect / scale, 0.0f),
-		glm::vec2(0.0f, 1.0f / scale),
-		glm::vec2(center.x, center.y)
-	);
+	//(shared with headless input replay, so it lives in the simulation)
+	glm::mat4 court_to_clip;
+	glm::mat3x2 clip_to_court;
+	sim.court_transforms(drawable_size, &court_to_clip, &clip_to_court);
 
 	//---- actual drawing ----
 
@@ -421,36 +203,30 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 	//don't use the depth test:
 	glDisable(GL_DEPTH_TEST);
 
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	//done writing rectangles (they're already in rect_stream.buffer; this just notes where):
+	const size_t first_rect = rect_stream.unmap< Rect >(rect_count);
 
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program.program);
+	//set rect_program as current program:
+	glUseProgram(rect_program.program);
 
 	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
-
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	glUniformMatrix4fv(rect_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
 
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
+	//use the mapping rect_stream_for_rect_program to fetch this frame's rectangles:
+	glBindVertexArray(rect_stream_for_rect_program);
+	rect_program.bind_rects(rect_stream.buffer, first_rect);
 
-	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
-
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//run the OpenGL pipeline (six vertices -- two triangles -- per rectangle instance):
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, GLsizei(rect_count));
 
 	//reset vertex array to none:
 	glBindVertexArray(0);
 
 	//reset current program to none:
 	glUseProgram(0);
-	
+
+	//this frame's part of rect_stream can be reused once the GPU is done with the draw above:
+	rect_stream.end_frame();
 
 	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
 
@@ -1,4 +1,8 @@
-#include "ColorTextureProgram.hpp"
+#pragma once
+
+#include "InstancedRectProgram.hpp"
+#include "PongSim.hpp"
+#include "StreamBuffer.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
@@ -6,7 +10,6 @@
 #include <glm/glm.hpp>
 
 #include <vector>
-#include <deque>
 
 /*
  * PongMode is a game mode that implements a single-player game of Pong.
@@ -19,58 +22,44 @@ struct PongMode : Mode {
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
-	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual void sync() override;
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) override;
 
 	//----- game state -----
-
-	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
-	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
-	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
-
-	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
-	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
-
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
-
-	uint32_t left_score = 0;
-	uint32_t right_score = 0;
-
-	float ai_offset = 0.0f;
-	float ai_offset_update = 0.0f;
-
-	//----- pretty gradient trails -----
-
-	float trail_length = 1.3f;
-	std::deque< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
+	//simulation state (paddles, ball, scores, trail) lives in PongSim so it can also be run headlessly:
+	// (written by handle_event() and update(); sizes never change, so draw() reads those directly)
+	PongSim sim;
+
+	//positions as of the previous update, for interpolating in draw():
+	glm::vec2 prev_right_paddle = sim.right_paddle;
+	glm::vec2 prev_ball = sim.ball;
+
+	//----- drawing state -----
+	//the parts of the simulation that change, as copied by sync(); the only game state draw() reads:
+	struct DrawState {
+		glm::vec2 left_paddle = glm::vec2(0.0f);
+		glm::vec2 right_paddle = glm::vec2(0.0f);
+		glm::vec2 prev_right_paddle = glm::vec2(0.0f);
+		glm::vec2 ball = glm::vec2(0.0f);
+		glm::vec2 prev_ball = glm::vec2(0.0f);
+		uint32_t left_score = 0;
+		uint32_t right_score = 0;
+		std::vector< glm::vec3 > ball_trail; //(keeps its capacity, so copying doesn't allocate once warmed up)
+	} drawing;
 
 	//----- opengl assets / helpers ------
 
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
-	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "PongMode::Vertex should be packed");
-
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
-
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
-
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
+	//draw functions will work on vectors of rectangles, each drawn as one instance by rect_program:
+	typedef InstancedRectProgram::Rect Rect;
 
-	//Solid white texture:
-	GLuint white_tex = 0;
+	//Shader program that draws transformed rectangles, one instance each:
+	InstancedRectProgram rect_program;
 
-	//matrix that maps from clip coordinates to court-space coordinates:
-	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
-	// (stored here so that the mouse handling code can use it to position the paddle)
+	//Ring buffer that draw() writes each frame's rectangles into:
+	StreamBuffer rect_stream;
 
+	//Vertex Array Object that maps buffer locations to rect_program attribute locations:
+	// (created by create_vertex_array() on first draw; pointed at each frame's rectangles as they are drawn)
+	GLuint rect_stream_for_rect_program = 0;
+	void create_vertex_array();
 };
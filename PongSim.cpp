@@ -0,0 +1,265 @@
+#include "PongSim.hpp"
+
+#include "hash_fnv1a.hpp"
+#include "swept_aabb.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PongSim::PongSim() {
+	//set up trail as if ball has been here for 'forever':
+	ball_trail.clear();
+	ball_trail.emplace_back(ball, trail_length);
+	ball_trail.emplace_back(ball, 0.0f);
+}
+
+bool PongSim::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	if (evt.type == SDL_MOUSEMOTION) {
+		//convert mouse from window pixels (top-left origin, +y is down) to clip space ([-1,1]x[-1,1], +y is up):
+		glm::vec2 clip_mouse = glm::vec2(
+			(evt.motion.x + 0.5f) / window_size.x * 2.0f - 1.0f,
+			(evt.motion.y + 0.5f) / window_size.y *-2.0f + 1.0f
+		);
+		glm::mat4 court_to_clip;
+		glm::mat3x2 clip_to_court;
+		court_transforms(window_size, &court_to_clip, &clip_to_court);
+		left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
+	}
+
+	return false;
+}
+
+void PongSim::update(float elapsed) {
+
+	//----- paddle update -----
+
+	{ //right player ai:
+		ai_offset_update -= elapsed;
+		if (ai_offset_update < elapsed) {
+			//update again in [0.5,1.0) seconds:
+			ai_offset_update = (mt() / float(mt.max())) * 0.5f + 0.5f;
+			ai_offset = (mt() / float(mt.max())) * 2.5f - 1.25f;
+		}
+		if (right_paddle.y < ball.y + ai_offset) {
+			right_paddle.y = std::min(ball.y + ai_offset, right_paddle.y + 2.0f * elapsed);
+		} else {
+			right_paddle.y = std::max(ball.y + ai_offset, right_paddle.y - 2.0f * elapsed);
+		}
+	}
+
+	//clamp paddles to court:
+	right_paddle.y = std::max(right_paddle.y, -court_radius.y + paddle_radius.y);
+	right_paddle.y = std::min(right_paddle.y,  court_radius.y - paddle_radius.y);
+
+	left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
+	left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
+
+	//----- ball update -----
+
+	//speed of ball doubles every four points:
+	float speed_multiplier = 4.0f * std::pow(2.0f, (left_score + right_score) / 4.0f);
+
+	//...up to a cap, since the swept collision below only handles so many bounces per step:
+	// (and since the ball's velocity would otherwise overflow to inf in a long enough game)
+	speed_multiplier = std::min(speed_multiplier, max_speed_multiplier);
+
+	//---- collision handling ----
+
+	//paddles:
+	auto paddle_bounce = [this](glm::vec2 const &paddle, bool in_x) {
+		if (!in_x) {
+			//bounce in y direction:
+			if (ball.y > paddle.y) {
+				ball.y = paddle.y + paddle_radius.y + ball_radius.y;
+				ball_velocity.y = std::abs(ball_velocity.y);
+			} else {
+				ball.y = paddle.y - paddle_radius.y - ball_radius.y;
+				ball_velocity.y = -std::abs(ball_velocity.y);
+			}
+		} else {
+			//bounce in x direction:
+			if (ball.x > paddle.x) {
+				ball.x = paddle.x + paddle_radius.x + ball_radius.x;
+				ball_velocity.x = std::abs(ball_velocity.x);
+			} else {
+				ball.x = paddle.x - paddle_radius.x - ball_radius.x;
+				ball_velocity.x = -std::abs(ball_velocity.x);
+			}
+			//warp y velocity based on offset from paddle center:
+			float vel = (ball.y - paddle.y) / (paddle_radius.y + ball_radius.y);
+			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
+		}
+	};
+	auto paddle_vs_ball = [this,&paddle_bounce](glm::vec2 const &paddle) {
+		//compute area of overlap:
+		glm::vec2 min = glm::max(paddle - paddle_radius, ball - ball_radius);
+		glm::vec2 max = glm::min(paddle + paddle_radius, ball + ball_radius);
+
+		//if no overlap, no collision:
+		if (min.x > max.x || min.y > max.y) return;
+
+		//wider overlap in x => bounce in y direction:
+		paddle_bounce(paddle, !(max.x - min.x > max.y - min.y));
+	};
+
+	//court walls (also counts a point when the ball reaches the left or right wall):
+	auto walls_vs_ball = [this]() {
+		if (ball.y >= court_radius.y - ball_radius.y) {
+			ball.y = court_radius.y - ball_radius.y;
+			if (ball_velocity.y > 0.0f) {
+				ball_velocity.y = -ball_velocity.y;
+			}
+		}
+		if (ball.y <= -court_radius.y + ball_radius.y) {
+			ball.y = -court_radius.y + ball_radius.y;
+			if (ball_velocity.y < 0.0f) {
+				ball_velocity.y = -ball_velocity.y;
+			}
+		}
+
+		if (ball.x >= court_radius.x - ball_radius.x) {
+			ball.x = court_radius.x - ball_radius.x;
+			if (ball_velocity.x > 0.0f) {
+				ball_velocity.x = -ball_velocity.x;
+				left_score += 1;
+			}
+		}
+		if (ball.x <= -court_radius.x + ball_radius.x) {
+			ball.x = -court_radius.x + ball_radius.x;
+			if (ball_velocity.x < 0.0f) {
+				ball_velocity.x = -ball_velocity.x;
+				right_score += 1;
+			}
+		}
+	};
+
+	//move the ball, bouncing off whatever it hits first, until the step is used up:
+	float remaining = elapsed;
+	for (uint32_t bounce = 0; bounce < MaxBallBounces; ++bounce) {
+		glm::vec2 velocity = speed_multiplier * ball_velocity;
+
+		float hit_t = remaining;
+		glm::vec2 const *hit_paddle = nullptr;
+		int hit_axis = 0;
+		int hit_wall = -1; //axis of the wall hit, if any
+
+		for (glm::vec2 const *paddle : {&left_paddle, &right_paddle}) {
+			float t;
+			int axis;
+			if (swept_aabb(ball, ball_radius, velocity, *paddle - paddle_radius, *paddle + paddle_radius, hit_t, &t, &axis)
+			 && (hit_paddle == nullptr || t < hit_t)) {
+				hit_t = t;
+				hit_paddle = paddle;
+				hit_axis = axis;
+			}
+		}
+
+		glm::vec2 limit = court_radius - ball_radius;
+		for (int a = 0; a < 2; ++a) {
+			if (velocity[a] == 0.0f) continue;
+			float wall = (velocity[a] > 0.0f ? limit[a] : -limit[a]);
+			float t = std::max(0.0f, (wall - ball[a]) / velocity[a]);
+			if (t < hit_t || (t == hit_t && hit_paddle == nullptr && hit_wall == -1)) {
+				hit_t = t;
+				hit_paddle = nullptr;
+				hit_wall = a;
+			}
+		}
+
+		if (hit_paddle == nullptr && hit_wall == -1) {
+			ball += remaining * velocity;
+			break;
+		}
+
+		//move to the point of contact and bounce:
+		ball += hit_t * velocity;
+		remaining -= hit_t;
+		if (hit_paddle) {
+			paddle_bounce(*hit_paddle, hit_axis == 0);
+		} else {
+			ball[hit_wall] = (velocity[hit_wall] > 0.0f ? limit[hit_wall] : -limit[hit_wall]);
+			walls_vs_ball();
+		}
+	}
+
+	//resolve anything the sweep can't see (e.g. a paddle that moved onto the ball):
+	paddle_vs_ball(left_paddle);
+	paddle_vs_ball(right_paddle);
+	walls_vs_ball();
+
+	//----- gradient trails -----
+
+	//age up all locations in ball trail:
+	for (auto &t : ball_trail) {
+		t.z += elapsed;
+	}
+	//store fresh location at back of ball trail:
+	ball_trail.emplace_back(ball, 0.0f);
+
+	//trim any too-old locations from back of trail:
+	//NOTE: since trail drawing interpolates between points, only removes back element if second-to-back element is too old:
+	size_t too_old = 0;
+	while (ball_trail.size() - too_old >= 2 && ball_trail[too_old + 1].z > trail_length) {
+		too_old += 1;
+	}
+	ball_trail.erase(ball_trail.begin(), ball_trail.begin() + too_old);
+}
+
+void PongSim::court_transforms(glm::uvec2 const &drawable_size, glm::mat4 *court_to_clip, glm::mat3x2 *clip_to_court) const {
+	//layout of the frame around the court (must match PongMode::draw):
+	const float wall_radius = 0.05f;
+	const float padding = 0.14f; //padding between outside of walls and edge of window
+	const glm::vec2 score_radius = glm::vec2(0.1f, 0.1f);
+
+	//compute area that should be visible:
+	glm::vec2 scene_min = glm::vec2(
+		-court_radius.x - 2.0f * wall_radius - padding,
+		-court_radius.y - 2.0f * wall_radius - padding
+	);
+	glm::vec2 scene_max = glm::vec2(
+		court_radius.x + 2.0f * wall_radius + padding,
+		court_radius.y + 2.0f * wall_radius + 3.0f * score_radius.y + padding
+	);
+
+	//compute window aspect ratio:
+	float aspect = drawable_size.x / float(drawable_size.y);
+	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
+
+	//compute scale factor for court given that...
+	float scale = std::min(
+		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
+		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
+	);
+
+	glm::vec2 center = 0.5f * (scene_max + scene_min);
+
+	//build matrix that scales and translates appropriately:
+	*court_to_clip = glm::mat4(
+		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, scale, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-center.x * (scale / aspect), -center.y * scale, 0.0f, 1.0f)
+	);
+	//NOTE: glm matrices are specified in *Column-Major* order,
+	// so each line above is specifying a *column* of the matrix(!)
+
+	//also build the matrix that takes clip coordinates to court coordinates (used for mouse handling):
+	*clip_to_court = glm::mat3x2(
+		glm::vec2(aspect / scale, 0.0f),
+		glm::vec2(0.0f, 1.0f / scale),
+		glm::vec2(center.x, center.y)
+	);
+}
+
+uint64_t PongSim::state_hash() const {
+	uint64_t hash = FNV1A_OFFSET;
+	hash = fnv1a(hash, left_paddle);
+	hash = fnv1a(hash, right_paddle);
+	hash = fnv1a(hash, ball);
+	hash = fnv1a(hash, ball_velocity);
+	hash = fnv1a(hash, left_score);
+	hash = fnv1a(hash, right_score);
+	hash = fnv1a(hash, ai_offset);
+	hash = fnv1a(hash, ai_offset_update);
+	return hash;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <random>
+#include <vector>
+#include <cstdint>
+
+/*
+ * PongSim holds the simulation state of a single-player game of Pong.
+ *  It owns no OpenGL resources, so it can be stepped without a window
+ *  (see sim_bench.cpp) as well as by PongMode.
+ */
+
+struct PongSim {
+	PongSim();
+
+	//input, called by PongMode::handle_event (or by headless drivers):
+	// the left paddle follows the mouse (mapped to the court with court_transforms(window_size))
+	// (headless drivers can also just set left_paddle.y directly)
+	bool handle_event(SDL_Event const &evt, glm::uvec2 const &window_size);
+
+	//advance the simulation by 'elapsed' seconds:
+	void update(float elapsed);
+
+	//transforms between court coordinates and clip space for a 'drawable_size' framebuffer:
+	// (used by PongMode::draw, and by handle_event to place the paddle)
+	void court_transforms(glm::uvec2 const &drawable_size, glm::mat4 *court_to_clip, glm::mat3x2 *clip_to_court) const;
+
+	//hash of the simulation state (for checking that two runs ended up identical):
+	uint64_t state_hash() const;
+
+	//----- game state -----
+
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
+	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+
+	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
+	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+
+	//the ball moves with swept (continuous) collision against paddles and walls,
+	// so it can't pass through paddles at any speed; this many bounces are handled per update:
+	static constexpr uint32_t MaxBallBounces = 8;
+	//...but the ball still has to stay slow enough that a tick doesn't need more bounces than that:
+	// (at 64x, the ball (|velocity| <= sqrt(2)) covers about 1.5 units in a 60Hz tick, far less than the court)
+	float max_speed_multiplier = 64.0f;
+
+	uint32_t left_score = 0;
+	uint32_t right_score = 0;
+
+	float ai_offset = 0.0f;
+	float ai_offset_update = 0.0f;
+
+	//----- pretty gradient trails -----
+
+	float trail_length = 1.3f;
+	//(a vector, trimmed from the front: it only holds a second or so of ticks, and unlike a deque
+	// it stops allocating once it has reached that size)
+	std::vector< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
+
+	//----- ai -----
+
+	std::mt19937 mt; //mersenne twister pseudo-random number generator
+};
@@ -0,0 +1,104 @@
+#include "ProjectilePool.hpp"
+
+#include "hash_fnv1a.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+ProjectilePool::ProjectilePool(uint32_t capacity_) : capacity(capacity_) {
+	position.reserve(capacity);
+	velocity.reserve(capacity);
+	state.reserve(capacity);
+}
+
+bool ProjectilePool::fire(BouncSim const &sim, glm::vec2 const &from, glm::vec2 const &target) {
+	glm::vec2 v = glm::normalize(target - from) * sim.ball_speed;
+	return spawn(from + sim.ball_pre_shift * v, v);
+}
+
+bool ProjectilePool::spawn(glm::vec2 const &position_, glm::vec2 const &velocity_, BouncSim::BallState state_) {
+	if (size() >= capacity) return false;
+	position.emplace_back(position_);
+	velocity.emplace_back(velocity_);
+	state.emplace_back(state_);
+	return true;
+}
+
+void ProjectilePool::remove(uint32_t index) {
+	assert(index < size());
+	position[index] = position.back();
+	velocity[index] = velocity.back();
+	state[index] = state.back();
+	position.pop_back();
+	velocity.pop_back();
+	state.pop_back();
+}
+
+void ProjectilePool::clear() {
+	position.clear();
+	velocity.clear();
+	state.clear();
+}
+
+void ProjectilePool::update_range(BouncSim const &sim, float elapsed, BouncSim::Collision path, uint32_t begin, uint32_t end, uint32_t thread) {
+	std::vector< uint32_t > *scratch = &candidates[thread];
+	glm::vec2 player_min = sim.player - sim.player_radius;
+	glm::vec2 player_max = sim.player + sim.player_radius;
+	bool hit = false;
+
+	for (uint32_t i = begin; i < end; ++i) {
+		glm::vec2 p = position[i];
+		glm::vec2 v = velocity[i];
+		sim.move_ball(&p, &v, elapsed, path, scratch);
+		position[i] = p;
+		velocity[i] = v;
+
+		//same test as the ball vs. player check at the end of BouncSim::update:
+		if (state[i] == BouncSim::BallState::CAN_HIT) {
+			glm::vec2 min = glm::max(player_min, p - sim.ball_radius);
+			glm::vec2 max = glm::min(player_max, p + sim.ball_radius);
+			if (!(min.x > max.x || min.y > max.y)) {
+				state[i] = BouncSim::BallState::FREE;
+				hit = true;
+			}
+		}
+	}
+
+	if (hit) hit_player[thread] = 1;
+}
+
+void ProjectilePool::update(BouncSim &sim, float elapsed, ThreadPool *pool) {
+	if (sim.stream) {
+		throw std::runtime_error("ProjectilePool only works on fixed levels, not endless ones.");
+	}
+	if (sim.has_ended) return; //(matches BouncSim::update, which stops the ball too)
+
+	uint32_t threads = (pool && size() >= MinParallel ? pool->threads() : 1);
+	if (candidates.size() < threads) candidates.resize(threads);
+	hit_player.assign(std::max< size_t >(hit_player.size(), threads), 0);
+
+	BouncSim::Collision path = sim.collision_path();
+	BouncSim const &level = sim;
+	if (threads == 1) {
+		update_range(level, elapsed, path, 0, size(), 0);
+	} else {
+		pool->parallel_for(size(), [&](uint32_t begin, uint32_t end, uint32_t thread) {
+			update_range(level, elapsed, path, begin, end, thread);
+		});
+	}
+
+	for (uint8_t h : hit_player) {
+		if (h) sim.do_bounce_jump = true;
+	}
+}
+
+uint64_t ProjectilePool::state_hash() const {
+	uint64_t hash = FNV1A_OFFSET;
+	for (uint32_t i = 0; i < size(); ++i) {
+		hash = fnv1a(hash, position[i]);
+		hash = fnv1a(hash, velocity[i]);
+		hash = fnv1a(hash, state[i]);
+	}
+	return hash;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "BouncSim.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * ProjectilePool holds many B.O.U.N.C. balls at once (thousands to 100k+).
+ *  Each one behaves like BouncSim's own ball: it bounces off the level's boxes and the ground,
+ *  and the first time it touches the player it triggers a B.O.U.N.C. jump.
+ *
+ * Storage is one array per field with a fixed capacity, allocated up front,
+ *  so firing, removing, and updating projectiles never allocate.
+ * update() can split the projectiles across a ThreadPool; the result doesn't depend on the thread count.
+ *
+ * Fixed levels only: on an endless level (BouncSim::enable_streaming) the ground and boxes follow the
+ *  player and ball, so projectiles elsewhere would fall out of the world (update() throws instead).
+ */
+
+struct ProjectilePool {
+	explicit ProjectilePool(uint32_t capacity);
+
+	uint32_t size() const { return uint32_t(position.size()); }
+	uint32_t const capacity;
+
+	//fire a projectile from 'from' toward 'target' the way BouncSim::fire fires the ball
+	// (returns false if the pool is full):
+	bool fire(BouncSim const &sim, glm::vec2 const &from, glm::vec2 const &target);
+	bool spawn(glm::vec2 const &position, glm::vec2 const &velocity, BouncSim::BallState state = BouncSim::BallState::CAN_HIT);
+
+	//remove projectile 'index' (the last projectile takes its place):
+	void remove(uint32_t index);
+	void clear();
+
+	//move every projectile through sim's level for 'elapsed' seconds;
+	// any that can still hit the player and touch them go FREE and set sim.do_bounce_jump:
+	// (call after sim.update(), as the ball's own player check runs at the end of it)
+	//NOTE: throws if 'sim' is an endless level
+	void update(BouncSim &sim, float elapsed, ThreadPool *pool = nullptr);
+
+	//hash of every projectile's state (for checking that thread counts don't change results):
+	uint64_t state_hash() const;
+
+	//----- projectile state -----
+	std::vector< glm::vec2 > position;
+	std::vector< glm::vec2 > velocity;
+	std::vector< BouncSim::BallState > state;
+
+	//----- internals -----
+	//below this many projectiles, update() doesn't bother with the pool:
+	static constexpr uint32_t MinParallel = 1024;
+	void update_range(BouncSim const &sim, float elapsed, BouncSim::Collision path, uint32_t begin, uint32_t end, uint32_t thread);
+	//per-thread scratch (grown, never shrunk, so steady-state updates don't allocate):
+	std::vector< std::vector< uint32_t > > candidates;
+	std::vector< uint8_t > hit_player; //(not vector< bool >, so threads can write their own entries)
+};
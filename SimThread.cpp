@@ -0,0 +1,69 @@
+#include "SimThread.hpp"
+
+#include "profile_zones.hpp"
+
+#include <chrono>
+
+SimThread::SimThread(FixedTimestep *timestep_) : timestep(timestep_) {
+	thread = std::thread(&SimThread::thread_loop, this);
+}
+
+SimThread::~SimThread() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		frame_done.wait(lock, [this](){ return !busy; });
+		quit = true;
+	}
+	frame_submitted.notify_one();
+	thread.join();
+}
+
+void SimThread::wait() {
+	PROFILE_ZONE("SimThread::wait");
+	std::unique_lock< std::mutex > lock(mutex);
+	frame_done.wait(lock, [this](){ return !busy; });
+}
+
+void SimThread::submit(std::shared_ptr< Mode > const &mode_, std::vector< SDL_Event > *frame_events, glm::uvec2 const &window_size_, float elapsed_) {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		frame_done.wait(lock, [this](){ return !busy; });
+		mode = mode_;
+		events.swap(*frame_events);
+		window_size = window_size_;
+		elapsed = elapsed_;
+		busy = true;
+	}
+	frame_submitted.notify_one();
+}
+
+void SimThread::thread_loop() {
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		frame_submitted.wait(lock, [this](){ return busy || quit; });
+		if (quit) break;
+
+		//the drawing thread doesn't touch the submitted frame (or the timestep) until it is done:
+		lock.unlock();
+		auto start = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_ZONE("SimThread::frame");
+			for (auto const &evt : events) {
+				mode->handle_event(evt, window_size);
+			}
+			events.clear();
+
+			timestep->accumulate(elapsed);
+			while (timestep->step()) {
+				mode->update(timestep->tick);
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		lock.lock();
+
+		last_frame_ms = std::chrono::duration< float, std::milli >(end - start).count();
+		mode.reset();
+		busy = false;
+		frame_done.notify_all();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Mode.hpp"
+#include "FixedTimestep.hpp"
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * SimThread runs a Mode's handle_event() and update() calls on a thread of their own,
+ *  so the simulation of frame N+1 overlaps with drawing (and swapping) frame N.
+ *
+ * Per frame, the drawing thread calls:
+ *   wait();            //the simulation of the previous frame is done (the simulation thread is idle)
+ *   mode->sync();      //copy its results into the mode's drawing state
+ *   (read timestep.alpha())
+ *   submit(...);       //start simulating this frame's events and elapsed time
+ *   mode->draw(...);   //draw the synced state while the simulation runs
+ *
+ * Latency: what is drawn is always exactly one frame behind the input that has been polled
+ *  (input polled in frame N first appears in frame N+1), and the simulation can never get more
+ *  than one frame ahead of drawing, since submit() only happens after wait().
+ */
+
+struct SimThread {
+	//'timestep' must outlive the SimThread; it belongs to the simulation thread between submit() and wait():
+	explicit SimThread(FixedTimestep *timestep);
+	~SimThread(); //waits for the current frame, then stops the thread
+
+	//block until the previously submitted frame has been simulated:
+	void wait();
+
+	//(after wait()) hand 'mode' this frame's events, then update it for 'elapsed' seconds:
+	// (the events are swapped out of 'frame_events', which is left empty but keeps its capacity)
+	void submit(std::shared_ptr< Mode > const &mode, std::vector< SDL_Event > *frame_events, glm::uvec2 const &window_size, float elapsed);
+
+	FixedTimestep *timestep;
+
+	//how long the last simulated frame took on the simulation thread, in milliseconds:
+	float last_frame_ms = 0.0f;
+
+	//----- internals -----
+	void thread_loop();
+
+	std::mutex mutex;
+	std::condition_variable frame_submitted;
+	std::condition_variable frame_done;
+	bool busy = false; //a frame has been submitted and not finished
+	bool quit = false;
+
+	//the submitted frame:
+	std::shared_ptr< Mode > mode; //(released before the frame is marked done, so Modes are never destroyed on this thread)
+	std::vector< SDL_Event > events;
+	glm::uvec2 window_size = glm::uvec2(0);
+	float elapsed = 0.0f;
+
+	std::thread thread;
+};
@@ -0,0 +1,83 @@
+#include "SkyProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+#include "startup_report.hpp"
+
+SkyProgram::SkyProgram() {
+	STARTUP_STAGE("SkyProgram");
+
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat3x2 CLIP_TO_COURT;\n"
+		"out vec2 court;\n"
+		"void main() {\n"
+		//one triangle that covers the whole screen:
+		"	vec2 clip = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);\n"
+		"	gl_Position = vec4(clip, 0.0, 1.0);\n"
+		"	court = CLIP_TO_COURT * vec3(clip, 1.0);\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"uniform float STAR_CELL;\n"
+		"uniform float STAR_RADIUS;\n"
+		"uniform vec4 STAR_COLOR;\n"
+		"uniform vec2 MOON_CENTER;\n"
+		"uniform float MOON_RADIUS;\n"
+		"uniform float MOON_RIM;\n"
+		"uniform vec4 MOON_COLOR;\n"
+		"uniform vec4 MOON_RIM_COLOR;\n"
+		"in vec2 court;\n"
+		"out vec4 fragColor;\n"
+		//integer hash (Jarzynski and Olano's pcg2d):
+		"uvec2 pcg2d(uvec2 v) {\n"
+		"	v = v * 1664525u + 1013904223u;\n"
+		"	v.x += v.y * 1664525u;\n"
+		"	v.y += v.x * 1664525u;\n"
+		"	v = v ^ (v >> 16u);\n"
+		"	v.x += v.y * 1664525u;\n"
+		"	v.y += v.x * 1664525u;\n"
+		"	v = v ^ (v >> 16u);\n"
+		"	return v;\n"
+		"}\n"
+		"void main() {\n"
+		//moon (in front of the stars):
+		"	float moon = length(court - MOON_CENTER);\n"
+		"	if (moon < MOON_RADIUS) {\n"
+		"		fragColor = (moon < MOON_RADIUS - MOON_RIM ? MOON_COLOR : MOON_RIM_COLOR);\n"
+		"		return;\n"
+		"	}\n"
+		//the star in this pixel's cell, somewhere inside the cell:
+		"	vec2 cell = floor(court / STAR_CELL);\n"
+		"	vec2 jitter = vec2(pcg2d(uvec2(ivec2(cell))) >> 8u) / 16777216.0;\n"
+		"	float margin = min(STAR_RADIUS / STAR_CELL, 0.5);\n"
+		"	vec2 star = (cell + margin + jitter * (1.0 - 2.0 * margin)) * STAR_CELL;\n"
+		"	vec2 d = abs(court - star);\n"
+		"	if (max(d.x, d.y) < STAR_RADIUS) {\n"
+		"		fragColor = STAR_COLOR;\n"
+		"		return;\n"
+		"	}\n"
+		"	discard;\n"
+		"}\n"
+	);
+
+	//look up the locations of uniforms:
+	CLIP_TO_COURT_mat3x2 = glGetUniformLocation(program, "CLIP_TO_COURT");
+	STAR_CELL_float = glGetUniformLocation(program, "STAR_CELL");
+	STAR_RADIUS_float = glGetUniformLocation(program, "STAR_RADIUS");
+	STAR_COLOR_vec4 = glGetUniformLocation(program, "STAR_COLOR");
+	MOON_CENTER_vec2 = glGetUniformLocation(program, "MOON_CENTER");
+	MOON_RADIUS_float = glGetUniformLocation(program, "MOON_RADIUS");
+	MOON_RIM_float = glGetUniformLocation(program, "MOON_RIM");
+	MOON_COLOR_vec4 = glGetUniformLocation(program, "MOON_COLOR");
+	MOON_RIM_COLOR_vec4 = glGetUniformLocation(program, "MOON_RIM_COLOR");
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+SkyProgram::~SkyProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
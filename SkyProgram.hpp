@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GL.hpp"
+
+//Shader program that fills the screen with a night sky -- a starfield and a moon -- computed per pixel:
+// draw it as one triangle (glDrawArrays(GL_TRIANGLES, 0, 3) with any vertex array object bound; it has no attributes).
+// Stars are hashed from the court position of each pixel: space is split into STAR_CELL-sized cells with
+// one STAR_RADIUS square star in each, so the sky costs the same however dense the stars are.
+// Pixels that are neither star nor moon are discarded (so whatever was cleared/drawn behind shows through).
+struct SkyProgram {
+	SkyProgram();
+	~SkyProgram();
+
+	GLuint program = 0;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint CLIP_TO_COURT_mat3x2 = -1U; //clip space to court (stars stay put in the court)
+	GLuint STAR_CELL_float = -1U; //cell size; one star per STAR_CELL x STAR_CELL square of court
+	GLuint STAR_RADIUS_float = -1U;
+	GLuint STAR_COLOR_vec4 = -1U;
+	GLuint MOON_CENTER_vec2 = -1U; //in court coordinates
+	GLuint MOON_RADIUS_float = -1U;
+	GLuint MOON_RIM_float = -1U; //width of the moon's outline
+	GLuint MOON_COLOR_vec4 = -1U;
+	GLuint MOON_RIM_COLOR_vec4 = -1U;
+};
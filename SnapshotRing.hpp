@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstdint>
+
+/*
+ * SnapshotRing keeps the last 'capacity' per-tick snapshots of a simulation's state
+ *  (e.g., BouncSim::snapshot()), for rolling back to an earlier tick or rewinding.
+ *
+ * Snapshots are numbered by tick: push() stores the state as of tick end_tick() and advances it;
+ *  once the ring is full, each push overwrites the oldest snapshot.
+ * All storage is allocated by the constructor, so pushing, looking up, and rewinding never allocate.
+ *
+ * Rollback: restore get(tick), truncate(tick + 1), then re-simulate, pushing each tick again.
+ * Rewind: pop() the newest snapshot and restore it, once per tick.
+ */
+
+template< typename STATE >
+struct SnapshotRing {
+	explicit SnapshotRing(uint32_t capacity) : states(capacity) {
+		assert(capacity > 0);
+	}
+
+	//record 'state' as the snapshot for tick end_tick():
+	void push(STATE const &state) {
+		states[end % states.size()] = state;
+		end += 1;
+		if (end - begin > states.size()) begin = end - states.size();
+	}
+
+	//snapshot for 'tick', or nullptr if it hasn't been pushed yet or has been overwritten:
+	STATE const *get(uint64_t tick) const {
+		if (tick < begin || tick >= end) return nullptr;
+		return &states[tick % states.size()];
+	}
+
+	//forget the snapshots for 'tick' and later (e.g., ticks about to be re-simulated):
+	void truncate(uint64_t tick) {
+		if (tick < end) end = (tick < begin ? begin : tick);
+	}
+
+	//remove the newest snapshot, copying it to 'state'; returns false if there are none:
+	bool pop(STATE *state) {
+		if (end == begin) return false;
+		end -= 1;
+		*state = states[end % states.size()];
+		return true;
+	}
+
+	//ticks [begin_tick(), end_tick()) have snapshots:
+	uint64_t begin_tick() const { return begin; }
+	uint64_t end_tick() const { return end; }
+	uint32_t size() const { return uint32_t(end - begin); }
+	uint32_t capacity() const { return uint32_t(states.size()); }
+
+	//----- internals -----
+	std::vector< STATE > states;
+	uint64_t begin = 0;
+	uint64_t end = 0;
+};
@@ -0,0 +1,101 @@
+#include "StreamBuffer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+StreamBuffer::StreamBuffer(size_t frame_bytes_) : frame_bytes(frame_bytes_) {
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, Frames * frame_bytes, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+StreamBuffer::~StreamBuffer() {
+	for (GLsync &fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = 0;
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+void StreamBuffer::wait(uint32_t part) {
+	if (!fences[part]) return;
+	//(the part was last written Frames frames ago, so this has almost always passed already)
+	while (glClientWaitSync(fences[part], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)) == GL_TIMEOUT_EXPIRED) { } //1s
+	glDeleteSync(fences[part]);
+	fences[part] = 0;
+}
+
+void *StreamBuffer::map_bytes(size_t bytes, size_t element_size) {
+	assert(!mapped && element_size > 0);
+
+	//make sure the GPU is done reading whatever this part held a few frames ago:
+	wait(frame);
+
+	size_t begin = (frame * frame_bytes + head + element_size - 1) / element_size * element_size;
+	if (begin + bytes > (frame + 1) * frame_bytes) {
+		//doesn't fit: re-specify the buffer with bigger parts (the old storage lives on until draws using it are done):
+		frame_bytes = std::max(frame_bytes * 2, bytes + element_size);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, Frames * frame_bytes, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		//(fences only guarded the old storage)
+		for (GLsync &fence : fences) {
+			if (fence) glDeleteSync(fence);
+			fence = 0;
+		}
+		head = 0;
+		begin = (frame * frame_bytes + element_size - 1) / element_size * element_size;
+	}
+
+	mapped_offset = begin;
+	mapped = true;
+	if (bytes == 0) return nullptr;
+	written = true;
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	mapped_ptr = glMapBufferRange(GL_ARRAY_BUFFER, begin, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!mapped_ptr) {
+		mapped = false;
+		throw std::runtime_error("StreamBuffer: failed to map " + std::to_string(bytes) + " bytes.");
+	}
+	return mapped_ptr;
+}
+
+size_t StreamBuffer::unmap_bytes(size_t bytes) {
+	assert(mapped);
+	mapped = false;
+	//(zero-byte maps don't map anything)
+	if (mapped_ptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		mapped_ptr = nullptr;
+	}
+
+	head = mapped_offset + bytes - frame * frame_bytes;
+	return mapped_offset;
+}
+
+void StreamBuffer::end_frame() {
+	assert(!mapped);
+	//a part that wasn't written this frame keeps whatever fence it had (which still guards its older contents);
+	// a written one was waited on (and its fence deleted) by map_bytes(), but don't count on that:
+	if (written) {
+		if (fences[frame]) glDeleteSync(fences[frame]);
+		fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	frame = (frame + 1) % Frames;
+	head = 0;
+	written = false;
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
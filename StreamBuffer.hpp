@@ -0,0 +1,67 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * StreamBuffer is a vertex buffer for data that is rewritten every frame, written straight into mapped memory:
+ *
+ *   Rect *rects = stream.map< Rect >(max_count); //room for up to max_count
+ *   ... write count <= max_count rects ...
+ *   size_t first = stream.unmap< Rect >(count); //index of rects[0] in stream.buffer
+ *   ... draw from stream.buffer, starting at element 'first' ...
+ *   stream.end_frame();
+ *
+ * The buffer is a ring of Frames parts, one per frame in flight. Mapping uses GL_MAP_UNSYNCHRONIZED_BIT,
+ *  so the driver never stalls or orphans the buffer; instead end_frame() fences the part just written,
+ *  and the first map() of a later frame waits on that fence before reusing the part (which, with
+ *  Frames frames between them, normally has long since passed).
+ *
+ * A frame that needs more room than its part has grows the whole ring (re-specifying its storage, so draws
+ *  already issued still read the old data); anything mapped earlier that frame must already have been drawn.
+ */
+
+struct StreamBuffer {
+	//'frame_bytes' is the initial room per frame:
+	explicit StreamBuffer(size_t frame_bytes = 16 * 1024);
+	~StreamBuffer();
+	StreamBuffer(StreamBuffer const &) = delete;
+	StreamBuffer &operator=(StreamBuffer const &) = delete;
+
+	//map room for 'count' T's in this frame's part of the ring:
+	//NOTE: will throw if the buffer can't be mapped
+	template< typename T >
+	T *map(size_t count) {
+		return static_cast< T * >(map_bytes(count * sizeof(T), sizeof(T)));
+	}
+	//unmap after writing 'count' T's; returns the index (in T's) of the first of them in 'buffer':
+	template< typename T >
+	size_t unmap(size_t count) {
+		return unmap_bytes(count * sizeof(T)) / sizeof(T);
+	}
+
+	//(byte versions; the mapped offset is a multiple of 'element_size')
+	void *map_bytes(size_t bytes, size_t element_size);
+	size_t unmap_bytes(size_t bytes);
+
+	//fence the current frame's writes (call after issuing the draws that read them) and move to the next part:
+	void end_frame();
+
+	GLuint buffer = 0;
+
+	//----- internals -----
+	enum : uint32_t { Frames = 3 };
+	size_t frame_bytes = 0;
+	uint32_t frame = 0; //which part of the ring the current frame writes
+	size_t head = 0; //next free byte in the current part
+	size_t mapped_offset = 0; //where the current mapping starts (in the whole buffer)
+	bool mapped = false; //between map_bytes() and unmap_bytes()
+	void *mapped_ptr = nullptr; //non-null while actually mapped
+	bool written = false; //anything was mapped in the current part this frame (so end_frame() should fence it)
+	std::array< GLsync, Frames > fences{}; //non-zero while a part may still be read by the GPU
+
+	void wait(uint32_t part);
+};
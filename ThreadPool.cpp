@@ -0,0 +1,153 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(uint32_t worker_count) : spans(worker_count + 1) {
+	workers.reserve(worker_count);
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		//(worker i handles range i + 1; the calling thread handles range 0)
+		workers.emplace_back(&ThreadPool::worker_loop, this, i + 1);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	job_ready.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+uint32_t ThreadPool::default_workers() {
+	uint32_t hardware = std::thread::hardware_concurrency();
+	return (hardware > 1 ? hardware - 1 : 0);
+}
+
+void ThreadPool::range(uint32_t thread, uint32_t *begin, uint32_t *end) const {
+	uint64_t n = threads();
+	*begin = uint32_t(uint64_t(count) * thread / n);
+	*end = uint32_t(uint64_t(count) * (thread + 1) / n);
+}
+
+void ThreadPool::run(uint32_t count_, Call call_, void const *body_) {
+	if (workers.empty()) {
+		call_(body_, 0, count_, 0);
+		return;
+	}
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		count = count_;
+		call = call_;
+		body = body_;
+		pending = uint32_t(workers.size());
+		generation += 1;
+	}
+	job_ready.notify_all();
+
+	uint32_t begin, end;
+	range(0, &begin, &end);
+	if (begin < end) call_(body_, begin, end, 0);
+
+	std::unique_lock< std::mutex > lock(mutex);
+	job_done.wait(lock, [this](){ return pending == 0; });
+}
+
+void ThreadPool::worker_loop(uint32_t thread) {
+	uint64_t seen = 0;
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		job_ready.wait(lock, [&](){ return generation != seen || quit; });
+		if (quit) break;
+		seen = generation;
+
+		//(the job doesn't change until every worker has finished it)
+		uint32_t begin, end;
+		range(thread, &begin, &end);
+		lock.unlock();
+		if (begin < end) call(body, begin, end, thread);
+		lock.lock();
+
+		pending -= 1;
+		if (pending == 0) job_done.notify_one();
+	}
+}
+
+static inline uint64_t pack(uint32_t begin, uint32_t end) {
+	return uint64_t(begin) << 32 | end;
+}
+static inline uint32_t span_begin(uint64_t range) { return uint32_t(range >> 32); }
+static inline uint32_t span_end(uint64_t range) { return uint32_t(range); }
+
+bool ThreadPool::take(uint32_t thread, uint32_t grain, uint32_t *begin, uint32_t *end) {
+	std::atomic< uint64_t > &range = spans[thread].range;
+	uint64_t current = range.load();
+	while (true) {
+		uint32_t b = span_begin(current), e = span_end(current);
+		if (b >= e) return false;
+		uint32_t split = (e - b > grain ? b + grain : e);
+		//(on failure, 'current' is reloaded and we try again)
+		if (range.compare_exchange_weak(current, pack(split, e))) {
+			*begin = b;
+			*end = split;
+			return true;
+		}
+	}
+}
+
+bool ThreadPool::steal(uint32_t thread) {
+	while (true) {
+		//the victim is whoever has the most left:
+		uint32_t victim = thread;
+		uint32_t most = 0;
+		uint64_t seen = 0;
+		for (uint32_t t = 0; t < spans.size(); ++t) {
+			if (t == thread) continue;
+			uint64_t current = spans[t].range.load();
+			uint32_t left = span_end(current) - span_begin(current);
+			if (span_begin(current) < span_end(current) && left > most) {
+				victim = t;
+				most = left;
+				seen = current;
+			}
+		}
+		if (victim == thread) return false;
+
+		//take the back half (all of it, if there's only one item):
+		uint32_t b = span_begin(seen), e = span_end(seen);
+		uint32_t mid = b + (e - b) / 2;
+		if (spans[victim].range.compare_exchange_strong(seen, pack(b, mid))) {
+			//(nothing else writes to an empty span, so a plain store is enough)
+			spans[thread].range.store(pack(mid, e));
+			return true;
+		}
+		//the victim's range changed while we looked; look again
+	}
+}
+
+void ThreadPool::run_stealing(uint32_t count_, uint32_t grain, Call call_, void const *body_) {
+	if (grain == 0) grain = 1;
+	uint64_t n = threads();
+	for (uint32_t t = 0; t < n; ++t) {
+		spans[t].range.store(pack(uint32_t(uint64_t(count_) * t / n), uint32_t(uint64_t(count_) * (t + 1) / n)));
+	}
+
+	//one "item" per thread, each of which works through its span and then steals until nothing's left:
+	struct Job {
+		ThreadPool *pool;
+		uint32_t grain;
+		Call call;
+		void const *body;
+	} job{ this, grain, call_, body_ };
+
+	run(uint32_t(n), [](void const *job_, uint32_t, uint32_t, uint32_t thread) {
+		Job const &job = *reinterpret_cast< Job const * >(job_);
+		uint32_t begin, end;
+		do {
+			while (job.pool->take(thread, job.grain, &begin, &end)) {
+				job.call(job.body, begin, end, thread);
+			}
+		} while (job.pool->steal(thread));
+	}, &job);
+}
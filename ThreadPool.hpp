@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * ThreadPool keeps a few worker threads around for splitting loops across cores.
+ *
+ * parallel_for(count, body) calls body(begin, end, thread) on threads() disjoint, contiguous
+ *  ranges covering [0, count), one per thread (the calling thread does one of them), and returns
+ *  when all of them are done. 'thread' is in [0, threads()), so callers can keep per-thread scratch.
+ *
+ * Ranges only depend on count and threads(), so results that are combined per range in order are
+ *  deterministic. Bodies must not throw. parallel_for doesn't allocate.
+ *
+ * parallel_for_stealing(count, grain, body) is for loops whose items take uneven amounts of time:
+ *  each thread starts on its own contiguous range as above, but takes it at most 'grain' items at a time,
+ *  and a thread that runs out steals the back half of whichever range has the most left.
+ *  body(begin, end, thread) is called once per piece, so which thread gets which items varies from run
+ *  to run; write results per item (not per thread) to keep them deterministic. It doesn't allocate either.
+ */
+
+struct ThreadPool {
+	//'workers' threads in addition to the calling thread (default: one per remaining hardware thread):
+	explicit ThreadPool(uint32_t worker_count = default_workers());
+	~ThreadPool();
+
+	static uint32_t default_workers();
+
+	//number of ranges parallel_for splits work into:
+	uint32_t threads() const { return uint32_t(workers.size()) + 1; }
+
+	template< typename Body >
+	void parallel_for(uint32_t count, Body const &body) {
+		run(count, [](void const *body_, uint32_t begin, uint32_t end, uint32_t thread) {
+			(*reinterpret_cast< Body const * >(body_))(begin, end, thread);
+		}, &body);
+	}
+
+	template< typename Body >
+	void parallel_for_stealing(uint32_t count, uint32_t grain, Body const &body) {
+		run_stealing(count, grain, [](void const *body_, uint32_t begin, uint32_t end, uint32_t thread) {
+			(*reinterpret_cast< Body const * >(body_))(begin, end, thread);
+		}, &body);
+	}
+
+	//----- internals -----
+	typedef void (*Call)(void const *body, uint32_t begin, uint32_t end, uint32_t thread);
+	void run(uint32_t count, Call call, void const *body);
+	void range(uint32_t thread, uint32_t *begin, uint32_t *end) const;
+	void worker_loop(uint32_t thread);
+
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	std::condition_variable job_done;
+	uint64_t generation = 0; //incremented for every job, so workers can tell a new one has arrived
+	uint32_t pending = 0; //workers that haven't finished the current job
+	bool quit = false;
+
+	//the current job:
+	uint32_t count = 0;
+	Call call = nullptr;
+	void const *body = nullptr;
+
+	std::vector< std::thread > workers;
+
+	//work stealing: each thread's remaining range, as (begin << 32 | end), changed only by compare-and-swap
+	// (a whole cache line each, so threads taking from their own ranges don't slow each other down):
+	struct Span {
+		std::atomic< uint64_t > range;
+		char padding[64 - sizeof(std::atomic< uint64_t >)];
+	};
+	std::vector< Span > spans;
+	void run_stealing(uint32_t count, uint32_t grain, Call call, void const *body);
+	//take up to 'grain' items from the front of thread's own span; false if it's empty:
+	bool take(uint32_t thread, uint32_t grain, uint32_t *begin, uint32_t *end);
+	//move the back half of the fullest other span to thread's own span; false if there's nothing left:
+	bool steal(uint32_t thread);
+};
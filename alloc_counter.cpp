@@ -0,0 +1,48 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//relaxed atomics: counts only need to be exact once threads have been joined:
+static std::atomic< uint64_t > allocations(0);
+static std::atomic< uint64_t > frees(0);
+static std::atomic< uint64_t > bytes(0);
+
+AllocCounts alloc_counts() {
+	AllocCounts ret;
+	ret.allocations = allocations.load(std::memory_order_relaxed);
+	ret.frees = frees.load(std::memory_order_relaxed);
+	ret.bytes = bytes.load(std::memory_order_relaxed);
+	return ret;
+}
+
+static void *counted_alloc(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	bytes.fetch_add(size, std::memory_order_relaxed);
+	void *ptr = std::malloc(size ? size : 1);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+static void counted_free(void *ptr) {
+	if (!ptr) return;
+	frees.fetch_add(1, std::memory_order_relaxed);
+	std::free(ptr);
+}
+
+void *operator new(std::size_t size) { return counted_alloc(size); }
+void *operator new[](std::size_t size) { return counted_alloc(size); }
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept {
+	try { return counted_alloc(size); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+	try { return counted_alloc(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::nothrow_t const &) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept { counted_free(ptr); }
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Counts heap allocations made through the global operator new/delete.
+ *  Linking alloc_counter.cpp into an executable replaces the global
+ *  allocation functions with counting versions; without it, these
+ *  functions are not available.
+ */
+
+struct AllocCounts {
+	uint64_t allocations = 0; //calls to operator new
+	uint64_t frees = 0; //calls to operator delete (with non-null pointer)
+	uint64_t bytes = 0; //total bytes requested from operator new
+};
+
+//counts since program start:
+AllocCounts alloc_counts();
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+/*
+ * Read-only pointer + length over a contiguous array of T, wherever it lives
+ *  (a std::vector, or memory that isn't owned by a container, like a mapped LevelFile).
+ * Supports what the simulation's loops need: size(), [], and range-for.
+ */
+
+template< typename T >
+struct ArrayView {
+	ArrayView() = default;
+	ArrayView(T const *data_, size_t size_) : ptr(data_), count(size_) { }
+	ArrayView(std::vector< T > const &vec) : ptr(vec.data()), count(vec.size()) { }
+
+	T const *data() const { return ptr; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T const &operator[](size_t i) const { return ptr[i]; }
+	T const *begin() const { return ptr; }
+	T const *end() const { return ptr + count; }
+
+	T const *ptr = nullptr;
+	size_t count = 0;
+};
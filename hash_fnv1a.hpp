@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * 64-bit FNV-1a hashing, used to fingerprint simulation state
+ *  (e.g., to check that a replay ends in exactly the same state).
+ */
+
+constexpr uint64_t FNV1A_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV1A_PRIME = 1099511628211ULL;
+
+inline uint64_t fnv1a(uint64_t hash, void const *data, size_t size) {
+	unsigned char const *bytes = reinterpret_cast< unsigned char const * >(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * FNV1A_PRIME;
+	}
+	return hash;
+}
+
+//hash the bytes of a trivially-copyable value (beware of padding):
+template< typename T >
+inline uint64_t fnv1a(uint64_t hash, T const &value) {
+	return fnv1a(hash, &value, sizeof(value));
+}
@@ -0,0 +1,95 @@
+//Offline level converter:
+// reads a text description of a B.O.U.N.C. level and writes it as a LevelFile
+// (the binary format 'bounc --level FILE' maps and uses in place; see LevelFile.hpp).
+//
+// usage: bounc-level-convert IN.txt OUT.blvl
+//
+// The description has one item per line ('#' starts a comment; blank lines are ignored);
+// boxes are given by center and half-size (radius), in court coordinates, as in BouncSim:
+//   box X Y RX RY         collision box (the player and ball hit these)
+//   ground X Y RX RY      the ground the ball bounces off (default: 0 -7 10 1, as in BouncSim)
+//   star X Y RX RY        scenery, back to front: stars,
+//   shadow2 X Y RX RY       far buildings,
+//   shadow X Y RX RY        and near buildings
+//   cell-size S           collision grid cell size (default: picked from the boxes)
+
+#include "LevelFile.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+static void read_description(std::string const &filename, LevelFile::Contents *contents) {
+	std::ifstream in(filename);
+	if (!in) {
+		throw std::runtime_error("Failed to open level description '" + filename + "'.");
+	}
+
+	std::string line;
+	uint32_t line_number = 0;
+	while (std::getline(in, line)) {
+		line_number += 1;
+		auto error = [&](std::string const &what) {
+			return std::runtime_error(filename + ":" + std::to_string(line_number) + ": " + what);
+		};
+
+		line = line.substr(0, line.find('#'));
+		std::istringstream words(line);
+		std::string kind;
+		if (!(words >> kind)) continue; //blank line
+
+		if (kind == "cell-size") {
+			if (!(words >> contents->cell_size) || !(contents->cell_size > 0.0f)) throw error("expecting 'cell-size S' with S > 0.");
+		} else {
+			glm::vec2 position, radius;
+			if (!(words >> position.x >> position.y >> radius.x >> radius.y)) throw error("expecting '" + kind + " X Y RX RY'.");
+			if (radius.x < 0.0f || radius.y < 0.0f) throw error("box has a negative radius.");
+			LevelFile::Box box(position, radius);
+			if (kind == "box") contents->boxes.emplace_back(box);
+			else if (kind == "ground") contents->ground = box;
+			else if (kind == "star") contents->stars.emplace_back(box);
+			else if (kind == "shadow2") contents->shadow2_boxes.emplace_back(box);
+			else if (kind == "shadow") contents->shadow_boxes.emplace_back(box);
+			else throw error("unknown item '" + kind + "'.");
+		}
+
+		std::string extra;
+		if (words >> extra) throw error("unexpected '" + extra + "' at end of line.");
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::cerr << "usage: " << argv[0] << " IN.txt OUT.blvl" << std::endl;
+		return 1;
+	}
+
+	try {
+		LevelFile::Contents contents;
+		read_description(argv[1], &contents);
+		LevelFile::write(argv[2], contents);
+
+		//map the result, both to check it and to show what loading it costs:
+		auto start = std::chrono::steady_clock::now();
+		std::shared_ptr< LevelFile const > file = LevelFile::open(argv[2]);
+		BouncSim sim;
+		sim.use_level_file(file);
+		auto end = std::chrono::steady_clock::now();
+
+		std::cout << "wrote '" << argv[2] << "': "
+			<< file->boxes().size() << " boxes, "
+			<< file->stars().size() << " stars, "
+			<< file->shadow2_boxes().size() + file->shadow_boxes().size() << " buildings, "
+			<< file->header().grid_cells.x << "x" << file->header().grid_cells.y << " grid, "
+			<< file->size << " bytes" << std::endl;
+		std::cout << "load: " << std::chrono::duration< double, std::micro >(end - start).count() << " us" << std::endl;
+	} catch (std::exception const &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,5 +1,7 @@
 #include "load_save_png.hpp"
 
+#include "profile_zones.hpp"
+
 #include <png.h>
 
 #include <iostream>
@@ -15,6 +17,7 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin);
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
+	PROFILE_ZONE("load_png");
 	assert(size);
 
 	std::ifstream file(filename.c_str(), std::ios::binary);
@@ -27,6 +30,7 @@ void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 >
 }
 
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
+	PROFILE_ZONE("save_png");
 	std::ofstream file(filename.c_str(), std::ios::binary);
 	save_png(file, size.x, size.y, data, origin);
 }
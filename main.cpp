@@ -1,24 +1,52 @@
 //Mode.hpp declares the "Mode::current" static member variable, which is used to decide where event-handling, updating, and drawing events go:
 #include "Mode.hpp"
 
-//The 'BouncMode' mode plays the game:
+//The 'BouncMode' mode plays the game (on an endless level with --mode endless, or a level file with --level FILE):
 #include "BouncMode.hpp"
+//...and 'PongMode' is still around (pick it with --mode pong):
+#include "PongMode.hpp"
+
+//for building modes in the background:
+#include "ModeLoader.hpp"
 
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
 
 //for screenshots:
-#include "load_save_png.hpp"
+#include "FrameCapture.hpp"
+
+//for fixed-rate updates, optionally on their own thread:
+#include "FixedTimestep.hpp"
+#include "SimThread.hpp"
+
+//for recording input to replay headlessly (see replay.cpp):
+#include "InputRecording.hpp"
+
+//for per-phase frame timing and its overlay:
+#include "FrameTimings.hpp"
+#include "FrameTimingHUD.hpp"
+
+//for counting heap allocations per frame:
+#include "alloc_counter.hpp"
+
+//for --startup-report:
+#include "startup_report.hpp"
+
+//for PROFILE_ZONE() instrumentation (compiled out unless ENABLE_PROFILE_ZONES is defined):
+#include "profile_zones.hpp"
 
 //Includes for libSDL:
 #include <SDL.h>
 
 //...and for c++ standard library functions:
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <string>
+#include <thread>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,10 +54,89 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//simulation rate; update() is always called with elapsed = 1 / tick_rate:
+	float tick_rate = 60.0f;
+
+	//simulate on a second thread, overlapped with drawing (adds one frame of latency; see SimThread.hpp):
+	bool pipelined = false;
+
+	//which game to play:
+	std::string mode_name = "bounc";
+
+	//level file to play B.O.U.N.C. on (made with 'bounc-level-convert'), if not empty:
+	std::string level_filename;
+
+	//log input + frame times to this file (for 'bounc-replay'), if not empty:
+	std::string record_filename;
+
+	//print how long each startup stage took, as a table or as JSON:
+	bool startup_report = false;
+	bool startup_report_json = false;
+
+	//show the frame timing overlay at startup (can also be toggled with F3):
+	bool show_timing_hud = false;
+
+	//continuous frame capture (started at launch with --capture-every, or toggled with F9):
+	bool capture_at_start = false;
+	uint32_t capture_every = 1;
+	std::string capture_prefix = "capture-";
+	uint32_t capture_workers = std::max(1U, std::thread::hardware_concurrency() / 2);
+	size_t capture_queue = 8;
+	PngWriter::Overflow capture_overflow = PngWriter::Overflow::Drop;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--tick-rate" && argi + 1 < argc) {
+			tick_rate = std::stof(argv[++argi]);
+			if (!(tick_rate > 0.0f)) {
+				std::cerr << "Tick rate must be positive." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--mode" && argi + 1 < argc && (std::string(argv[argi+1]) == "bounc" || std::string(argv[argi+1]) == "endless" || std::string(argv[argi+1]) == "pong")) {
+			mode_name = argv[++argi];
+		} else if (arg == "--level" && argi + 1 < argc) {
+			level_filename = argv[++argi];
+		} else if (arg == "--record" && argi + 1 < argc) {
+			record_filename = argv[++argi];
+		} else if (arg == "--pipelined") {
+			pipelined = true;
+		} else if (arg == "--startup-report" || arg == "--startup-report=table") {
+			startup_report = true;
+		} else if (arg == "--startup-report=json") {
+			startup_report = true;
+			startup_report_json = true;
+		} else if (arg == "--timing-hud") {
+			show_timing_hud = true;
+		} else if (arg == "--capture-every" && argi + 1 < argc) {
+			capture_at_start = true;
+			capture_every = std::max(1, std::stoi(argv[++argi]));
+		} else if (arg == "--capture-prefix" && argi + 1 < argc) {
+			capture_prefix = argv[++argi];
+		} else if (arg == "--capture-workers" && argi + 1 < argc) {
+			capture_workers = std::max(1, std::stoi(argv[++argi]));
+		} else if (arg == "--capture-queue" && argi + 1 < argc) {
+			capture_queue = std::max(1, std::stoi(argv[++argi]));
+		} else if (arg == "--capture-block") {
+			capture_overflow = PngWriter::Overflow::Block;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--mode bounc|endless|pong] [--level FILE] [--tick-rate HZ] [--pipelined] [--record FILE] [--timing-hud] [--startup-report[=json]]\n"
+				"\t\t[--capture-every N] [--capture-prefix PREFIX] [--capture-workers N] [--capture-queue N] [--capture-block]" << std::endl;
+			return 1;
+		}
+	}
+
 	//------------  initialization ------------
 
+	//everything from here to the end of the first frame is timed for --startup-report:
+	if (startup_report) startup_report_begin();
+
 	//Initialize SDL library:
-	SDL_Init(SDL_INIT_VIDEO);
+	{
+		STARTUP_STAGE("SDL_Init");
+		SDL_Init(SDL_INIT_VIDEO);
+	}
 
 	//Ask for an OpenGL context version 3.3, core profile, enable debug:
 	SDL_GL_ResetAttributes();
@@ -46,14 +153,18 @@ int main(int argc, char **argv) {
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
 	//create window:
-	SDL_Window *window = SDL_CreateWindow(
-		"B.O.U.N.C.", //TODO: remember to set a title for your game!
-		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-		1280, 720, //TODO: modify window size if you'd like
-		SDL_WINDOW_OPENGL
-		| SDL_WINDOW_RESIZABLE //uncomment to allow resizing
-		| SDL_WINDOW_ALLOW_HIGHDPI //uncomment for full resolution on high-DPI screens
-	);
+	SDL_Window *window = nullptr;
+	{
+		STARTUP_STAGE("SDL_CreateWindow");
+		window = SDL_CreateWindow(
+			"B.O.U.N.C.", //TODO: remember to set a title for your game!
+			SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+			1280, 720, //TODO: modify window size if you'd like
+			SDL_WINDOW_OPENGL
+			| SDL_WINDOW_RESIZABLE //uncomment to allow resizing
+			| SDL_WINDOW_ALLOW_HIGHDPI //uncomment for full resolution on high-DPI screens
+		);
+	}
 
 	//prevent exceedingly tiny windows when resizing:
 	SDL_SetWindowMinimumSize(window, 100, 100);
@@ -64,7 +175,11 @@ int main(int argc, char **argv) {
 	}
 
 	//Create OpenGL context:
-	SDL_GLContext context = SDL_GL_CreateContext(window);
+	SDL_GLContext context = nullptr;
+	{
+		STARTUP_STAGE("SDL_GL_CreateContext");
+		context = SDL_GL_CreateContext(window);
+	}
 
 	if (!context) {
 		SDL_DestroyWindow(window);
@@ -73,13 +188,19 @@ int main(int argc, char **argv) {
 	}
 
 	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
-	init_GL();
+	{
+		STARTUP_STAGE("init_GL");
+		init_GL();
+	}
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
-		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
-		if (SDL_GL_SetSwapInterval(1) != 0) {
-			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
+	{
+		STARTUP_STAGE("vsync setup");
+		if (SDL_GL_SetSwapInterval(-1) != 0) {
+			std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
+			if (SDL_GL_SetSwapInterval(1) != 0) {
+				std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
+			}
 		}
 	}
 
@@ -87,7 +208,24 @@ int main(int argc, char **argv) {
 	//SDL_ShowCursor(SDL_DISABLE);
 
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< BouncMode >());
+	auto make_mode = [mode_name, level_filename]() -> std::shared_ptr< Mode > {
+		if (mode_name == "pong") {
+			return std::make_shared< PongMode >();
+		} else {
+			return std::make_shared< BouncMode >(mode_name == "endless", level_filename);
+		}
+	};
+	{
+		STARTUP_STAGE("create mode");
+		Mode::set_current(make_mode());
+	}
+
+	//later modes (e.g., restarting with F5) are built on a loader thread and swapped in when ready:
+	std::unique_ptr< ModeLoader > mode_loader;
+	{
+		STARTUP_STAGE("ModeLoader context + thread");
+		mode_loader = std::make_unique< ModeLoader >(window);
+	}
 
 	//------------ main loop ------------
 
@@ -106,44 +244,153 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//fixed-timestep scheduling: wall-clock time is accumulated and consumed in tick-sized steps:
+	FixedTimestep timestep(tick_rate);
+
+	//with --pipelined, handle_event() and update() run here, and this thread only polls events and draws:
+	std::unique_ptr< SimThread > sim_thread;
+	std::vector< SDL_Event > frame_events; //events polled this frame, to hand to sim_thread
+	if (pipelined) {
+		sim_thread = std::make_unique< SimThread >(&timestep);
+	}
+
+	//input recording:
+	std::unique_ptr< InputRecorder > recorder;
+	if (!record_filename.empty()) {
+		recorder = std::make_unique< InputRecorder >(record_filename, mode_name, tick_rate, window_size, drawable_size);
+		std::cout << "Recording input to '" << record_filename << "'." << std::endl;
+	}
+
+	//per-phase timing of the main loop (cheap enough to always record):
+	FrameTimings frame_timings;
+	//(held by pointer so it can be freed before the OpenGL context is)
+	std::unique_ptr< FrameTimingHUD > timing_hud;
+	{
+		STARTUP_STAGE("FrameTimingHUD");
+		timing_hud = std::make_unique< FrameTimingHUD >();
+	}
+
+	//asynchronous framebuffer readback + PNG encoding for screenshots and continuous capture:
+	std::unique_ptr< FrameCapture > frame_capture;
+	{
+		STARTUP_STAGE("FrameCapture + PNG writer threads");
+		frame_capture = std::make_unique< FrameCapture >(capture_workers, capture_queue, capture_overflow);
+	}
+	bool screenshot_requested = false;
+	if (capture_at_start) {
+		frame_capture->start_sequence(capture_prefix, capture_every);
+	}
+
+	//idle throttling: frames where nothing would change on screen aren't drawn,
+	// and the next pass through the loop sleeps in SDL_WaitEventTimeout instead:
+	bool redraw_requested = true; //forces the next frame to be drawn (e.g., after resizing)
+	uint32_t idle_wait_ms = 0; //how long the events phase may block waiting for input
+	//when the mode reports nothing is changing, nothing will until there is input, so it's fine to sleep for a while:
+	// (e.g., BouncMode's end screen; during play the ball is always moving, so every frame is drawn)
+	const uint32_t StaticIdleWaitMs = 100;
+
+	auto phase_start = std::chrono::high_resolution_clock::now();
+	//records time since the end of the previous phase:
+	auto end_phase = [&](FrameTimings::Phase phase) {
+		auto now = std::chrono::high_resolution_clock::now();
+		frame_timings.record(phase, std::chrono::duration< float, std::milli >(now - phase_start).count());
+		phase_start = now;
+	};
+
+	//heap allocations as of the end of the previous frame (frames are recorded with how many they made):
+	uint64_t allocations_before = alloc_counts().allocations;
+	//(skipped frames aren't in the history, so their allocations are totalled here instead of landing on the next drawn frame)
+	uint64_t idle_allocations = 0;
+
+	//the first pass through the loop is the last startup stage:
+	std::unique_ptr< StartupStage > first_frame_stage = std::make_unique< StartupStage >("first frame");
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
+		uint32_t mode_events = 0; //events passed to the mode this frame
+		float alpha = 0.0f; //fraction of a tick between the last update and now, used to interpolate when drawing
+		float next_tick_in = 0.0f; //time until the next update is due
+
 		{ //(1) process any events that are pending
+			PROFILE_ZONE("events");
 			static SDL_Event evt;
-			while (SDL_PollEvent(&evt) == 1) {
+			//if the last frame was skipped, block until input arrives (or it is time to update again):
+			bool have_event = false;
+			if (idle_wait_ms) {
+				have_event = (SDL_WaitEventTimeout(&evt, idle_wait_ms) == 1);
+				//(time spent asleep isn't part of any phase)
+				phase_start = std::chrono::high_resolution_clock::now();
+			}
+			while (have_event || SDL_PollEvent(&evt) == 1) {
+				have_event = false;
 				//handle resizing:
 				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 					on_resize();
 				}
+				//window contents may need to be re-shown:
+				if (evt.type == SDL_WINDOWEVENT) {
+					redraw_requested = true;
+				}
+				//log everything the mode sees:
+				if (recorder) recorder->event(evt, window_size, drawable_size);
 				//handle input:
-				if (Mode::current && Mode::current->handle_event(evt, window_size)) {
+				// (when pipelined, the mode sees events on the simulation thread a moment later,
+				//  so the keys below can't be overridden by the mode)
+				mode_events += 1;
+				if (sim_thread) {
+					frame_events.emplace_back(evt);
+				}
+				if (!sim_thread && Mode::current && Mode::current->handle_event(evt, window_size)) {
 					// mode handled it; great
 				} else if (evt.type == SDL_QUIT) {
+					//(mode must not be in use by the simulation thread when it is freed)
+					if (sim_thread) sim_thread->wait();
 					Mode::set_current(nullptr);
 					break;
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
 					// --- screenshot key ---
-					std::string filename = "screenshot.png";
-					std::cout << "Saving screenshot to '" << filename << "'." << std::endl;
-					glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-					glReadBuffer(GL_FRONT);
-					int w,h;
-					SDL_GL_GetDrawableSize(window, &w, &h);
-					std::vector< glm::u8vec4 > data(w*h);
-					glReadPixels(0,0,w,h, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-					for (auto &px : data) {
-						px.a = 0xff;
+					//(captured after this frame is drawn; see below)
+					screenshot_requested = true;
+					redraw_requested = true;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					// --- frame timing overlay key ---
+					show_timing_hud = !show_timing_hud;
+					redraw_requested = true;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F4) {
+					// --- write profile zones key ---
+					PROFILE_WRITE("profile.json");
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F5) {
+					// --- restart key ---
+					//(a fresh mode is built in the background; see the swap below)
+					mode_loader->load(make_mode);
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F9) {
+					// --- continuous capture key ---
+					if (frame_capture->sequence_active) {
+						frame_capture->stop_sequence();
+					} else {
+						frame_capture->start_sequence(capture_prefix, capture_every);
 					}
-					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
 				}
 			}
 			if (!Mode::current) break;
+
+			//switch to a mode from the loader once it has finished building:
+			if (std::shared_ptr< Mode > loaded = mode_loader->take()) {
+				//(the old mode must not be in use by the simulation thread when it is freed)
+				if (sim_thread) sim_thread->wait();
+				Mode::set_current(loaded);
+				//(replay restarts at the same point; when pipelined, the new mode also gets this frame's events)
+				if (recorder) recorder->restart(bool(sim_thread));
+				std::cout << "Switched to a mode loaded in the background (" << mode_loader->last_load_ms << "ms)." << std::endl;
+			}
+			end_phase(FrameTimings::Events);
 		}
 
-		{ //(2) call the current mode's "update" function to deal with elapsed time:
+		{ //(2) call the current mode's "update" function once per tick of elapsed time:
+			PROFILE_ZONE("update");
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
@@ -153,22 +400,127 @@ int main(int argc, char **argv) {
 			//lag to avoid spiral of death:
 			elapsed = std::min(0.1f, elapsed);
 
-			Mode::current->update(elapsed);
-			if (!Mode::current) break;
+			if (recorder) recorder->end_frame(elapsed);
+
+			if (sim_thread) {
+				//finish simulating the previous frame, take its results for drawing, and start on this frame:
+				// (the update phase is only the time spent waiting for the simulation thread)
+				sim_thread->wait();
+				Mode::current->sync();
+				alpha = timestep.alpha();
+				next_tick_in = timestep.tick - timestep.accumulator;
+				sim_thread->submit(Mode::current, &frame_events, window_size, elapsed);
+			} else {
+				timestep.accumulate(elapsed);
+				while (timestep.step()) {
+					Mode::current->update(timestep.tick);
+					if (!Mode::current) break;
+				}
+				if (!Mode::current) break;
+				Mode::current->sync();
+				alpha = timestep.alpha();
+				next_tick_in = timestep.tick - timestep.accumulator;
+			}
+			end_phase(FrameTimings::Update);
 		}
 
+		//decide whether this frame needs to be drawn at all:
+		// (nothing is visible while minimized or hidden; otherwise ask the mode, unless something else needs the frame)
+		bool visible = !(SDL_GetWindowFlags(window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN));
+		bool draw_frame = visible && (redraw_requested || show_timing_hud || frame_capture->sequence_active || Mode::current->needs_redraw());
+		if (!draw_frame) {
+			//sleep until input arrives; while hidden, wake up in time for the next tick so the game keeps running:
+			// (input this frame may still change what's drawn, so don't sleep then)
+			// (and don't keep a finished background load waiting long)
+			if (mode_events) {
+				idle_wait_ms = 0;
+			} else if (mode_loader->loading()) {
+				idle_wait_ms = 5;
+			} else if (visible) {
+				idle_wait_ms = StaticIdleWaitMs;
+			} else {
+				idle_wait_ms = std::max(1U, uint32_t(std::ceil(next_tick_in * 1000.0f)));
+			}
+			frame_capture->poll(); //(still finish any screenshots in flight)
+			//idle frames aren't added to the frame timing history:
+			uint64_t allocations = alloc_counts().allocations;
+			idle_allocations += allocations - allocations_before;
+			allocations_before = allocations;
+			continue;
+		}
+		redraw_requested = false;
+		idle_wait_ms = 0;
+
 		{ //(3) call the current mode's "draw" function to produce output:
-		
-			Mode::current->draw(drawable_size);
+			PROFILE_ZONE("draw");
+			Mode::current->draw(drawable_size, alpha);
+
+			//overlay (its cost is counted as part of the draw phase):
+			if (show_timing_hud) {
+				timing_hud->draw(frame_timings, drawable_size);
+			}
+
+			//start reading back the frame if a screenshot was asked for:
+			if (screenshot_requested) {
+				std::string filename = "screenshot.png";
+				if (frame_capture->capture(drawable_size, filename)) {
+					std::cout << "Saving screenshot to '" << filename << "'." << std::endl;
+				} else {
+					std::cerr << "Screenshot skipped: previous captures are still being read back." << std::endl;
+				}
+				screenshot_requested = false;
+			}
+			frame_capture->sequence_frame(drawable_size);
+			end_phase(FrameTimings::Draw);
+		}
+
+		{ //Wait until the recently-drawn frame is shown before doing it all again:
+			PROFILE_ZONE("swap");
+			SDL_GL_SwapWindow(window);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		//pass finished screenshot readbacks to the PNG writer thread:
+		frame_capture->poll();
+
+		end_phase(FrameTimings::Swap);
+		uint64_t allocations = alloc_counts().allocations;
+		frame_timings.record_allocations(uint32_t(allocations - allocations_before));
+		allocations_before = allocations;
+		frame_timings.end_frame();
+
+		if (first_frame_stage) {
+			first_frame_stage.reset();
+			startup_report_end(std::cout, startup_report_json);
+		}
+	}
+
+	{ //summarize frame timing history:
+		std::vector< float > scratch;
+		FrameTimings::Stats stats = frame_timings.stats(&scratch);
+		std::cout << "Frame time over last " << frame_timings.size() << " frames: "
+			<< "p50 " << stats.p50_ms << "ms, p99 " << stats.p99_ms << "ms, max " << stats.max_ms << "ms." << std::endl;
+		std::cout << "Heap allocations over those frames: " << stats.allocations << " in " << stats.allocating_frames << " frames";
+		if (stats.allocating_frames) std::cout << " (most recent " << stats.frames_since_allocation << " frames before exit)";
+		std::cout << "." << std::endl;
+		if (idle_allocations) std::cout << "Heap allocations in skipped (idle) frames: " << idle_allocations << "." << std::endl;
 	}
 
 
+	//write any profile zones that were recorded (load in chrome://tracing or ui.perfetto.dev):
+	PROFILE_WRITE("profile.json");
+
+	if (recorder) {
+		std::cout << "Recorded " << recorder->frames << " frames (" << recorder->events << " events) to '" << recorder->filename << "'." << std::endl;
+		recorder.reset();
+	}
+
 	//------------  teardown ------------
 
+	sim_thread.reset();
+	mode_loader.reset();
+	timing_hud.reset();
+	frame_capture.reset(); //(finishes pending screenshots)
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
@@ -0,0 +1,145 @@
+#include "profile_zones.hpp"
+
+#ifdef ENABLE_PROFILE_ZONES
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event {
+	char const *name;
+	uint64_t begin_ns;
+	uint64_t end_ns;
+};
+
+//events are stored field-by-field in relaxed atomics so the trace writer can read slots
+// that the owning thread might be overwriting at the same time (it throws those away; see below):
+struct EventSlot {
+	std::atomic< char const * > name{nullptr};
+	std::atomic< uint64_t > begin_ns{0};
+	std::atomic< uint64_t > end_ns{0};
+};
+
+//one per thread; only the owning thread writes 'slots' and 'head':
+struct ThreadBuffer {
+	enum : uint32_t { Capacity = 1 << 16 }; //power of two, so event i lives in slot i % Capacity
+	uint32_t tid = 0;
+	std::atomic< uint64_t > head{0}; //events ever recorded; published with release so the writer sees whole events
+	EventSlot slots[Capacity];
+};
+
+//all buffers ever created; buffers outlive their threads so late writes still see them:
+std::mutex buffers_mutex;
+std::vector< std::unique_ptr< ThreadBuffer > > &buffers() {
+	static std::vector< std::unique_ptr< ThreadBuffer > > all;
+	return all;
+}
+
+ThreadBuffer &thread_buffer() {
+	thread_local ThreadBuffer *buffer = nullptr;
+	if (!buffer) {
+		std::unique_ptr< ThreadBuffer > fresh(new ThreadBuffer);
+		std::lock_guard< std::mutex > lock(buffers_mutex);
+		fresh->tid = uint32_t(buffers().size()) + 1;
+		buffer = fresh.get();
+		buffers().emplace_back(std::move(fresh));
+	}
+	return *buffer;
+}
+
+uint64_t now_ns() {
+	static auto const epoch = std::chrono::steady_clock::now();
+	return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - epoch).count());
+}
+
+} //namespace
+
+ProfileZone::ProfileZone(char const *name_) : name(name_), begin_ns(now_ns()) {
+}
+
+ProfileZone::~ProfileZone() {
+	uint64_t end_ns = now_ns();
+	ThreadBuffer &buffer = thread_buffer();
+	uint64_t index = buffer.head.load(std::memory_order_relaxed);
+	//(when the ring is full, this overwrites the oldest event)
+	EventSlot &slot = buffer.slots[index % ThreadBuffer::Capacity];
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+	slot.end_ns.store(end_ns, std::memory_order_relaxed);
+	buffer.head.store(index + 1, std::memory_order_release);
+}
+
+bool profile_zones_write(std::string const &filename) {
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) {
+		std::cerr << "Failed to open '" << filename << "' for writing profile zones." << std::endl;
+		return false;
+	}
+
+	//JSON string escaping for zone names:
+	auto write_string = [&out](char const *str) {
+		out << '"';
+		for (char const *c = str; *c; ++c) {
+			if (*c == '"' || *c == '\\') out << '\\';
+			out << *c;
+		}
+		out << '"';
+	};
+
+	uint64_t total = 0;
+	uint64_t dropped = 0;
+
+	std::lock_guard< std::mutex > lock(buffers_mutex);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	std::vector< Event > events;
+	for (auto const &buffer : buffers()) {
+		//copy out the newest Capacity events:
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		uint64_t begin = (head > ThreadBuffer::Capacity ? head - ThreadBuffer::Capacity : 0);
+		events.clear();
+		for (uint64_t i = begin; i < head; ++i) {
+			EventSlot const &slot = buffer->slots[i % ThreadBuffer::Capacity];
+			events.emplace_back(Event{
+				slot.name.load(std::memory_order_relaxed),
+				slot.begin_ns.load(std::memory_order_relaxed),
+				slot.end_ns.load(std::memory_order_relaxed)
+			});
+		}
+		//the owning thread kept recording while we copied; anything it may have overwritten meanwhile is thrown away:
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t head_after = buffer->head.load(std::memory_order_relaxed);
+		uint64_t valid = (head_after > ThreadBuffer::Capacity ? head_after - ThreadBuffer::Capacity : 0);
+		uint64_t skip = std::min(std::max(valid, begin) - begin, uint64_t(events.size()));
+		dropped += begin + skip;
+
+		for (auto event_it = events.begin() + skip; event_it != events.end(); ++event_it) {
+			Event const &event = *event_it;
+			if (!first) out << ",\n";
+			first = false;
+			//complete ("X") events, times in microseconds:
+			out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"name\":";
+			write_string(event.name);
+			out << ",\"ts\":" << event.begin_ns / 1000 << '.' << (event.begin_ns % 1000) / 100
+				<< ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000 << '.' << ((event.end_ns - event.begin_ns) % 1000) / 100
+				<< "}";
+		}
+		total += events.size() - skip;
+	}
+	//(trace viewers show "otherData" as the trace's metadata)
+	out << "\n],\"otherData\":{\"zones\":\"" << total << "\",\"overwritten_zones\":\"" << dropped << "\"}}\n";
+
+	std::cout << "Wrote " << total << " profile zones to '" << filename << "'";
+	if (dropped) std::cout << " (" << dropped << " older ones were overwritten because a thread's buffer was full)";
+	std::cout << "." << std::endl;
+	return bool(out);
+}
+
+#endif //ENABLE_PROFILE_ZONES
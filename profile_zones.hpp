@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+ * Scoped instrumentation zones, written as a chrome://tracing / Perfetto JSON file.
+ *
+ * Usage:
+ *   void thing() {
+ *     PROFILE_ZONE("thing"); //times from here to end of scope
+ *     ...
+ *   }
+ *   PROFILE_WRITE("profile.json"); //write everything recorded so far
+ *
+ * Zones are only compiled in when ENABLE_PROFILE_ZONES is defined
+ *  (build with 'jam -sPROFILE_ZONES=1' after a 'jam clean');
+ *  otherwise the macros expand to nothing.
+ *
+ * Each thread records into its own fixed-size ring buffer without locking.
+ *  Once a thread's ring is full, new zones overwrite its oldest ones, so a trace
+ *  always holds the most recent zones (the number overwritten is reported in the trace).
+ */
+
+#ifdef ENABLE_PROFILE_ZONES
+
+#include <cstdint>
+#include <string>
+
+struct ProfileZone {
+	//'name' must have static storage duration (e.g., a string literal):
+	explicit ProfileZone(char const *name);
+	~ProfileZone();
+
+	ProfileZone(ProfileZone const &) = delete;
+	ProfileZone &operator=(ProfileZone const &) = delete;
+
+	char const *name;
+	uint64_t begin_ns;
+};
+
+//write all zones recorded so far (on all threads) to 'filename'; returns false on failure:
+bool profile_zones_write(std::string const &filename);
+
+#define PROFILE_ZONE_CONCAT2(A, B) A ## B
+#define PROFILE_ZONE_CONCAT(A, B) PROFILE_ZONE_CONCAT2(A, B)
+#define PROFILE_ZONE(NAME) ProfileZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__)(NAME)
+#define PROFILE_WRITE(FILENAME) profile_zones_write(FILENAME)
+
+#else //ENABLE_PROFILE_ZONES
+
+#define PROFILE_ZONE(NAME) do { } while (0)
+#define PROFILE_WRITE(FILENAME) do { } while (0)
+
+#endif //ENABLE_PROFILE_ZONES
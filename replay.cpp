@@ -0,0 +1,148 @@
+//Headless input replay:
+// feeds a log written by 'bounc --record FILE' back through BouncSim or PongSim
+// as fast as possible and reports throughput and a hash of the final state.
+// Two runs of the same build on the same recording should always print the same hash.
+//
+// usage: bounc-replay FILE [--repeat N] [--level LEVEL]
+//  (recordings of 'bounc --level LEVEL' need the same level file passed with --level)
+
+#include "InputRecording.hpp"
+#include "FixedTimestep.hpp"
+#include "BouncSim.hpp"
+#include "LevelFile.hpp"
+#include "PongSim.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+struct ReplayResult {
+	uint64_t frames = 0;
+	uint64_t ticks = 0;
+	uint64_t events = 0;
+	uint64_t restarts = 0;
+	uint64_t hash = 0;
+};
+
+//per-mode setup, as main.cpp's make_mode does it:
+static void setup(BouncSim &sim, std::string const &mode, std::shared_ptr< LevelFile const > const &level) {
+	if (level) sim.use_level_file(level);
+	else if (mode == "endless") sim.enable_streaming();
+}
+static void setup(PongSim &, std::string const &, std::shared_ptr< LevelFile const > const &) {
+}
+
+//replays the recording the same way main.cpp's loop would have run it:
+template< typename Sim >
+static ReplayResult replay(InputRecording const &recording, std::shared_ptr< LevelFile const > const &level) {
+	ReplayResult result;
+
+	std::unique_ptr< Sim > sim(new Sim);
+	setup(*sim, recording.mode, level);
+	FixedTimestep timestep(recording.tick_rate);
+	glm::uvec2 window_size = recording.window_size;
+
+	for (auto const &frame : recording.frames) {
+		//(1) events:
+		for (auto const &event : frame.events) {
+			if (event.type == InputRecording::Restart) {
+				//the game swapped in a fresh mode here (F5):
+				sim.reset(new Sim);
+				setup(*sim, recording.mode, level);
+				result.restarts += 1;
+				continue;
+			}
+			if (event.type == SDL_WINDOWEVENT) {
+				window_size = glm::uvec2(event.a, event.b);
+			}
+			sim->handle_event(InputRecording::to_sdl(event), window_size);
+			result.events += 1;
+		}
+
+		//(2) update:
+		timestep.accumulate(frame.elapsed);
+		while (timestep.step()) {
+			sim->update(timestep.tick);
+			result.ticks += 1;
+		}
+
+		result.frames += 1;
+	}
+
+	result.hash = sim->state_hash();
+	return result;
+}
+
+int main(int argc, char **argv) {
+	std::string filename;
+	std::string level_filename;
+	uint32_t repeat = 1;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--repeat" && argi + 1 < argc) {
+			repeat = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--level" && argi + 1 < argc) {
+			level_filename = argv[++argi];
+		} else if (filename.empty() && arg[0] != '-') {
+			filename = arg;
+		} else {
+			filename.clear();
+			break;
+		}
+	}
+	if (filename.empty()) {
+		std::cerr << "usage: " << argv[0] << " FILE [--repeat N] [--level LEVEL]" << std::endl;
+		return 1;
+	}
+
+	InputRecording recording;
+	std::shared_ptr< LevelFile const > level;
+	try {
+		recording.load(filename);
+		if (!level_filename.empty()) level = LevelFile::open(level_filename);
+	} catch (std::exception const &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	ReplayResult (*run)(InputRecording const &, std::shared_ptr< LevelFile const > const &) = nullptr;
+	if (recording.mode == "bounc" || recording.mode == "endless") run = replay< BouncSim >;
+	else if (recording.mode == "pong") run = replay< PongSim >;
+	else {
+		std::cerr << "Recording is of unknown mode '" << recording.mode << "'." << std::endl;
+		return 1;
+	}
+
+	//each repeat starts from a fresh simulation, so all of them must end in the same state:
+	ReplayResult result;
+	bool deterministic = true;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t r = 0; r < repeat; ++r) {
+		ReplayResult this_result = run(recording, level);
+		if (r > 0 && this_result.hash != result.hash) deterministic = false;
+		result = this_result;
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration< double >(end - start).count();
+
+	std::cout << std::fixed;
+	std::cout << "mode:       " << recording.mode << " @ " << std::setprecision(1) << recording.tick_rate << " Hz\n";
+	std::cout << "frames:     " << result.frames << " (" << result.events << " events, " << result.restarts << " restarts)\n";
+	std::cout << "ticks:      " << result.ticks << " x " << repeat << "\n";
+	std::cout << "seconds:    " << std::setprecision(4) << seconds << "\n";
+	std::cout << "ticks/s:    " << std::setprecision(0) << (result.ticks * double(repeat)) / seconds << "\n";
+	std::cout << "state hash: " << std::hex << std::setw(16) << std::setfill('0') << result.hash << std::dec << std::endl;
+
+	if (!deterministic) {
+		std::cerr << "ERROR: repeats of the same recording ended in different states." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
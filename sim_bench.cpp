@@ -0,0 +1,538 @@
+//Headless simulation benchmark:
+// steps BouncSim or PongSim for many ticks without a window or OpenGL context
+// and reports throughput and heap allocation counts.
+//
+// usage: bounc-sim-bench [bounc|pong] [--ticks N] [--dt SECONDS]
+//        (pong exits with an error if the ball ended up non-finite, so a long run doubles as a stability check)
+//        bounc-sim-bench bounc --boxes N [--collision grid|simd|scalar]   (bigger levels, choice of collision path)
+//        bounc-sim-bench --box-sweep [--ticks N]      (per-tick cost for 10 .. 1,000,000 boxes)
+//        bounc-sim-bench --overlap-bench              (BoxSoA::overlap_mask vs. the scalar loop)
+//        bounc-sim-bench --projectiles N [--threads T] (N extra balls in a ProjectilePool, updated on T worker threads)
+//        bounc-sim-bench --batch N                    (N games at once in a BouncBatch; env-steps/s)
+//        bounc-sim-bench --endless [--ticks N]        (per-tick cost and resident chunks while crossing an endless level)
+//        bounc-sim-bench --rollback [--ticks N]       (snapshot / restore cost, and re-simulating after rolling back)
+
+#include "BouncBatch.hpp"
+#include "BouncSim.hpp"
+#include "LevelStream.hpp"
+#include "PongSim.hpp"
+#include "ProjectilePool.hpp"
+#include "SnapshotRing.hpp"
+#include "ThreadPool.hpp"
+
+//counting replacements for operator new/delete:
+#include "alloc_counter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+
+//scripted input so the benchmark exercises running, jumping, firing, and dying:
+static void drive_bounc(BouncSim &sim, uint64_t tick) {
+	if (tick % 600 == 0) sim.key_down(SDLK_d); //run right...
+	if (tick % 600 == 300) sim.key_down(SDLK_a); //...then left
+	if (tick % 40 == 0) sim.key_down(SDLK_SPACE); //jump whenever possible
+	if (tick % 45 == 0) sim.fire(sim.player + glm::vec2(1.0f, -2.0f)); //B.O.U.N.C. off the roof
+
+	//if the player wins, put them back at the start so later ticks aren't trivially cheap:
+	if (sim.has_ended) {
+		sim.has_ended = false;
+		sim.player = sim.player_start;
+		sim.player_state = BouncSim::PlayerState::AIR;
+	}
+}
+
+//replace the level with 'count' boxes on a lattice with constant density, starting around the court,
+// so the neighborhood the player and ball move through looks the same no matter how many boxes there are:
+static void make_level(BouncSim &sim, uint32_t count) {
+	uint32_t columns = uint32_t(std::ceil(std::sqrt(double(count))));
+	sim.boxes.clear();
+	sim.boxes.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t x = i % columns;
+		uint32_t y = i / columns;
+		//(vary sizes a bit, deterministically)
+		float w = 0.4f + 0.1f * float((i * 7) % 5);
+		float h = 0.3f + 0.1f * float((i * 3) % 4);
+		sim.boxes.emplace_back(glm::vec2(-12.0f + 3.0f * x, -12.0f + 3.0f * y), glm::vec2(w, h));
+	}
+	sim.build_collision();
+}
+
+static void drive_pong(PongSim &sim, uint64_t tick) {
+	//sweep the player's paddle up and down:
+	sim.left_paddle.y = 4.0f * std::sin(tick * 0.01f);
+}
+
+struct BenchResult {
+	uint64_t ticks = 0;
+	double seconds = 0.0;
+	AllocCounts allocs;
+};
+
+template< typename Sim, typename Drive >
+static BenchResult run(Sim &sim, Drive const &drive, uint64_t ticks, float dt) {
+	BenchResult result;
+	result.ticks = ticks;
+
+	AllocCounts before = alloc_counts();
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t tick = 0; tick < ticks; ++tick) {
+		drive(sim, tick);
+		sim.update(dt);
+	}
+	auto end = std::chrono::steady_clock::now();
+	AllocCounts after = alloc_counts();
+
+	result.seconds = std::chrono::duration< double >(end - start).count();
+	result.allocs.allocations = after.allocations - before.allocations;
+	result.allocs.frees = after.frees - before.frees;
+	result.allocs.bytes = after.bytes - before.bytes;
+	return result;
+}
+
+static void report(std::string const &mode, BenchResult const &result) {
+	std::cout << std::fixed;
+	std::cout << "mode:        " << mode << "\n";
+	std::cout << "ticks:       " << result.ticks << "\n";
+	std::cout << "seconds:     " << std::setprecision(4) << result.seconds << "\n";
+	std::cout << "ticks/s:     " << std::setprecision(0) << result.ticks / result.seconds << "\n";
+	std::cout << "ns/tick:     " << std::setprecision(2) << result.seconds * 1e9 / result.ticks << "\n";
+	std::cout << "allocations: " << result.allocs.allocations
+		<< " (" << std::setprecision(4) << double(result.allocs.allocations) / result.ticks << "/tick, "
+		<< result.allocs.bytes << " bytes, " << result.allocs.frees << " frees)\n";
+}
+
+//per-tick cost of BouncSim as the level grows, for each collision path:
+static void box_sweep(uint64_t ticks, float dt) {
+	std::cout << std::fixed;
+	std::cout << "    boxes   grid ns/tick   simd ns/tick  scalar ns/tick\n";
+	for (uint32_t count = 10; count <= 1000000; count *= 10) {
+		std::cout << std::setw(9) << count << std::setprecision(1);
+		for (auto path : {BouncSim::Collision::Grid, BouncSim::Collision::Simd, BouncSim::Collision::Scalar}) {
+			BouncSim sim;
+			make_level(sim, count);
+			sim.collision = path;
+			//(paths that test every box get fewer ticks as the level grows, so the sweep finishes)
+			uint64_t path_ticks = ticks;
+			if (path != BouncSim::Collision::Grid) {
+				path_ticks = std::max< uint64_t >(100, std::min< uint64_t >(ticks, ticks * 100 / count));
+			}
+			BenchResult result = run(sim, drive_bounc, path_ticks, dt);
+			std::cout << std::setw(path == BouncSim::Collision::Scalar ? 16 : 15) << result.seconds * 1e9 / result.ticks;
+		}
+		std::cout << std::endl;
+	}
+}
+
+//raw overlap test throughput: one rectangle against every box of a lattice level, SIMD vs. scalar:
+static void overlap_bench() {
+#if defined(BOX_SOA_AVX2)
+	char const *simd_name = "avx2";
+#elif defined(BOX_SOA_SSE2)
+	char const *simd_name = "sse2";
+#else
+	char const *simd_name = "none (scalar)";
+#endif
+	std::cout << "simd: " << simd_name << "\n";
+	std::cout << std::fixed;
+	std::cout << "    boxes  simd ns/box  scalar ns/box  hits\n";
+	for (uint32_t count : {8u, 64u, 1024u, 65536u, 1048576u}) {
+		BouncSim sim;
+		make_level(sim, count);
+		BoxSoA const &soa = sim.box_soa;
+		uint64_t tests = std::max< uint64_t >(uint64_t(count), 100000000ULL / count * count);
+		uint32_t queries = uint32_t(tests / count);
+
+		//sweep a player-sized rectangle across the level:
+		auto query_rect = [&](uint32_t q, glm::vec2 *min, glm::vec2 *max) {
+			glm::vec2 at = glm::vec2(-12.0f + float(q % 97) * 0.37f, -12.0f + float(q % 89) * 0.41f);
+			*min = at - glm::vec2(0.2f);
+			*max = at + glm::vec2(0.2f);
+		};
+
+		uint64_t hits[2] = {0, 0};
+		double seconds[2] = {0.0, 0.0};
+		for (uint32_t scalar = 0; scalar < 2; ++scalar) {
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t q = 0; q < queries; ++q) {
+				glm::vec2 min, max;
+				query_rect(q, &min, &max);
+				for (uint32_t first = 0; first < soa.count; first += BoxSoA::Lanes) {
+					uint32_t mask = scalar ? soa.overlap_mask_scalar(first, min, max) : soa.overlap_mask(first, min, max);
+					//(popcount, portably)
+					for (; mask; mask &= mask - 1) hits[scalar] += 1;
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+			seconds[scalar] = std::chrono::duration< double >(end - start).count();
+		}
+		std::cout << std::setw(9) << count << std::setprecision(3)
+			<< std::setw(13) << seconds[0] * 1e9 / (double(queries) * count)
+			<< std::setw(15) << seconds[1] * 1e9 / (double(queries) * count)
+			<< "  " << hits[0] << (hits[0] == hits[1] ? "" : " (MISMATCH with scalar!)") << std::endl;
+	}
+}
+
+//projectiles/second for a ProjectilePool of 'count' balls bouncing around the game's level:
+static void projectile_bench(uint32_t count, uint32_t workers, uint64_t ticks, float dt) {
+	BouncSim sim;
+	ProjectilePool projectiles(count);
+	ThreadPool pool(workers);
+
+	//fire from random spots around the court in random directions:
+	std::mt19937 mt(0x0b0c);
+	std::uniform_real_distribution< float > unit(-1.0f, 1.0f);
+	for (uint32_t i = 0; i < count; ++i) {
+		glm::vec2 from = glm::vec2(unit(mt) * sim.court_radius.x, unit(mt) * sim.court_radius.y);
+		glm::vec2 dir = glm::vec2(unit(mt), unit(mt));
+		if (dir == glm::vec2(0.0f)) dir = glm::vec2(1.0f, 0.0f);
+		projectiles.fire(sim, from, from + dir);
+	}
+
+	//(one untimed tick, so per-thread scratch has been allocated)
+	sim.update(dt);
+	projectiles.update(sim, dt, &pool);
+
+	AllocCounts before = alloc_counts();
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t tick = 0; tick < ticks; ++tick) {
+		drive_bounc(sim, tick);
+		sim.update(dt);
+		projectiles.update(sim, dt, &pool);
+	}
+	auto end = std::chrono::steady_clock::now();
+	AllocCounts after = alloc_counts();
+	double seconds = std::chrono::duration< double >(end - start).count();
+
+	std::cout << std::fixed;
+	std::cout << "projectiles:   " << projectiles.size() << "\n";
+	std::cout << "threads:       " << pool.threads() << "\n";
+	std::cout << "ticks:         " << ticks << "\n";
+	std::cout << "seconds:       " << std::setprecision(4) << seconds << "\n";
+	std::cout << "projectiles/s: " << std::setprecision(0) << double(projectiles.size()) * ticks / seconds << "\n";
+	std::cout << "ms/tick:       " << std::setprecision(3) << seconds * 1e3 / ticks << "\n";
+	std::cout << "allocations:   " << (after.allocations - before.allocations) << "\n";
+	std::cout << "state hash:    " << std::hex << std::setw(16) << std::setfill('0') << projectiles.state_hash() << std::dec << std::setfill(' ') << std::endl;
+}
+
+//scripted input for the lanes of a BouncBatch, like drive_bounc but with each lane's schedule offset
+// by lane * 7 ticks (kept as per-lane counters, since dividing by the periods every tick would cost
+// about as much as stepping the lane):
+struct BatchDriver {
+	explicit BatchDriver(uint32_t lanes) {
+		for (uint32_t lane = 0; lane < lanes; ++lane) {
+			run.emplace_back((lane * 7) % 600);
+			jump.emplace_back((lane * 7) % 40);
+			fire.emplace_back((lane * 7) % 45);
+		}
+	}
+	std::vector< uint32_t > run, jump, fire; //(tick + lane * 7) % 600, % 40, % 45
+
+	void drive(BouncBatch &batch) {
+		for (uint32_t lane = 0; lane < run.size(); ++lane) {
+			uint8_t action = batch.action[lane];
+			if (run[lane] == 0) action = BouncBatch::Right;
+			if (run[lane] == 300) action = BouncBatch::Left;
+			if (jump[lane] == 0) action |= BouncBatch::Jump;
+			if (fire[lane] == 0) {
+				action |= BouncBatch::Fire;
+				batch.target_x[lane] = batch.player_x[lane] + 1.0f;
+				batch.target_y[lane] = batch.player_y[lane] - 2.0f;
+			}
+			batch.action[lane] = action;
+			run[lane] = (run[lane] + 1 == 600 ? 0 : run[lane] + 1);
+			jump[lane] = (jump[lane] + 1 == 40 ? 0 : jump[lane] + 1);
+			fire[lane] = (fire[lane] + 1 == 45 ? 0 : fire[lane] + 1);
+
+			//(as in drive_bounc, winners go back to the start)
+			if (batch.has_ended[lane]) {
+				batch.has_ended[lane] = 0;
+				batch.player_x[lane] = batch.level.player_start.x;
+				batch.player_y[lane] = batch.level.player_start.y;
+				batch.player_state[lane] = uint32_t(BouncSim::PlayerState::AIR);
+			}
+		}
+	}
+};
+
+//the same input, given to a BouncSim:
+static void drive_sim_like_lane(BouncSim &sim, uint32_t lane, uint64_t tick, uint8_t *held) {
+	uint64_t t = tick + lane * 7;
+	if (t % 600 == 0) *held = BouncBatch::Right;
+	if (t % 600 == 300) *held = BouncBatch::Left;
+	sim.player_velocity.x = (*held == BouncBatch::Right ? sim.velocity_scale : (*held == BouncBatch::Left ? -sim.velocity_scale : 0.0f));
+	if (t % 40 == 0) sim.key_down(SDLK_SPACE);
+	if (t % 45 == 0) sim.fire(sim.player + glm::vec2(1.0f, -2.0f));
+	if (sim.has_ended) {
+		sim.has_ended = false;
+		sim.player = sim.player_start;
+		sim.player_state = BouncSim::PlayerState::AIR;
+	}
+}
+
+//env-steps/second for a BouncBatch of 'lanes' games on the game's level:
+static void batch_bench(uint32_t lanes, uint64_t ticks, float dt) {
+	BouncSim level;
+	level.collision = BouncSim::Collision::Scalar;
+
+	//check lanes against separate BouncSims first:
+	bool matches = true;
+	{
+		uint32_t check_lanes = std::min(lanes, 64u);
+		BouncBatch batch(level, check_lanes);
+		BatchDriver driver(check_lanes);
+		std::vector< BouncSim > sims(check_lanes);
+		std::vector< uint8_t > held(check_lanes, 0);
+		for (auto &sim : sims) sim.collision = BouncSim::Collision::Scalar;
+		for (uint64_t tick = 0; tick < 10000; ++tick) {
+			driver.drive(batch);
+			for (uint32_t lane = 0; lane < check_lanes; ++lane) {
+				drive_sim_like_lane(sims[lane], lane, tick, &held[lane]);
+			}
+			batch.step(dt);
+			for (auto &sim : sims) sim.update(dt);
+		}
+		for (uint32_t lane = 0; lane < check_lanes; ++lane) {
+			if (batch.state_hash(lane) != sims[lane].state_hash()) matches = false;
+		}
+	}
+
+	BouncBatch batch(level, lanes);
+	BatchDriver driver(lanes);
+	AllocCounts before = alloc_counts();
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t tick = 0; tick < ticks; ++tick) {
+		driver.drive(batch);
+		batch.step(dt);
+	}
+	auto end = std::chrono::steady_clock::now();
+	AllocCounts after = alloc_counts();
+	double seconds = std::chrono::duration< double >(end - start).count();
+
+	std::cout << std::fixed;
+	std::cout << "lanes:       " << lanes << "\n";
+	std::cout << "ticks:       " << ticks << "\n";
+	std::cout << "seconds:     " << std::setprecision(4) << seconds << "\n";
+	std::cout << "env-steps/s: " << std::setprecision(0) << double(lanes) * ticks / seconds << "\n";
+	std::cout << "ns/env-step: " << std::setprecision(2) << seconds * 1e9 / (double(lanes) * ticks) << "\n";
+	std::cout << "allocations: " << (after.allocations - before.allocations) << "\n";
+	std::cout << "matches BouncSim: " << (matches ? "yes" : "NO") << std::endl;
+}
+
+//carries the player across an endless level (much faster than they could run) and reports
+// per-tick cost and resident chunks along the way, which should stay flat:
+static void endless_bench(uint64_t ticks, float dt) {
+	std::cout << std::fixed;
+	std::cout << "    distance   ns/tick  max ns/tick  chunks  allocations  state hash\n";
+
+	const float speed = 1.0f; //units per tick (60 units/s at the default dt; running is 4 units/s)
+	const uint64_t report_every = std::max< uint64_t >(1, ticks / 10);
+
+	BouncSim sim;
+	sim.enable_streaming();
+	double seconds = 0.0;
+	double max_seconds = 0.0;
+	AllocCounts before = alloc_counts();
+	for (uint64_t tick = 0; tick < ticks; ++tick) {
+		drive_bounc(sim, tick);
+		//(keep the player up in the air, moving right)
+		sim.player += glm::vec2(speed, 0.0f);
+		sim.player.y = 3.0f;
+
+		auto start = std::chrono::steady_clock::now();
+		sim.update(dt);
+		auto end = std::chrono::steady_clock::now();
+		double s = std::chrono::duration< double >(end - start).count();
+		seconds += s;
+		max_seconds = std::max(max_seconds, s);
+
+		if ((tick + 1) % report_every == 0) {
+			AllocCounts after = alloc_counts();
+			uint32_t resident = 0;
+			for (auto const &chunk : sim.stream->slots) {
+				if (chunk.ready) resident += 1;
+			}
+			std::cout << std::setw(12) << std::setprecision(0) << sim.player.x
+				<< std::setw(10) << std::setprecision(1) << seconds * 1e9 / report_every
+				<< std::setw(13) << max_seconds * 1e9
+				<< std::setw(8) << resident
+				<< std::setw(13) << (after.allocations - before.allocations)
+				<< "  " << std::hex << std::setw(16) << std::setfill('0') << sim.state_hash() << std::dec << std::setfill(' ') << std::endl;
+			seconds = 0.0;
+			max_seconds = 0.0;
+			before = after;
+		}
+	}
+}
+
+//plays with a snapshot taken every tick, like rollback netcode would: every so often it rolls back
+// a few ticks, re-simulates them with the same input, and checks that it ends up where it was:
+static void rollback_bench(uint64_t ticks, float dt) {
+	const uint32_t Window = 600; //ticks of history (10 seconds at 60 Hz)
+	const uint32_t RollbackEvery = 100, RollbackTicks = 30;
+
+	BouncSim sim;
+	SnapshotRing< BouncState > history(Window);
+	uint64_t resimulated = 0;
+	uint64_t mismatches = 0;
+	double snapshot_seconds = 0.0;
+	double restore_seconds = 0.0;
+	uint64_t restores = 0;
+
+	//one tick, with its snapshot taken first (so history.get(tick) is the state 'tick' started from):
+	auto step = [&](uint64_t tick) {
+		auto start = std::chrono::steady_clock::now();
+		history.push(sim.snapshot());
+		auto end = std::chrono::steady_clock::now();
+		snapshot_seconds += std::chrono::duration< double >(end - start).count();
+		drive_bounc(sim, tick);
+		sim.update(dt);
+	};
+
+	AllocCounts before = alloc_counts();
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t tick = 0; tick < ticks; ++tick) {
+		step(tick);
+
+		if ((tick + 1) % RollbackEvery == 0) {
+			uint64_t now = tick + 1;
+			uint64_t expected = sim.state_hash();
+
+			auto restore_start = std::chrono::steady_clock::now();
+			uint64_t back = now - RollbackTicks;
+			sim.restore(*history.get(back));
+			auto restore_end = std::chrono::steady_clock::now();
+			restore_seconds += std::chrono::duration< double >(restore_end - restore_start).count();
+			restores += 1;
+
+			history.truncate(back);
+			for (uint64_t t = back; t < now; ++t) step(t);
+			resimulated += RollbackTicks;
+			if (sim.state_hash() != expected) mismatches += 1;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	AllocCounts after = alloc_counts();
+	double seconds = std::chrono::duration< double >(end - start).count();
+
+	std::cout << std::fixed;
+	std::cout << "state size:   " << sizeof(BouncState) << " bytes\n";
+	std::cout << "history:      " << history.size() << " of " << history.capacity() << " ticks\n";
+	std::cout << "ticks:        " << ticks << " (+" << resimulated << " re-simulated after " << restores << " rollbacks)\n";
+	std::cout << "seconds:      " << std::setprecision(4) << seconds << "\n";
+	std::cout << "ns/snapshot:  " << std::setprecision(1) << snapshot_seconds * 1e9 / double(ticks + resimulated) << " (including the clock reads)\n";
+	std::cout << "ns/restore:   " << std::setprecision(1) << restore_seconds * 1e9 / double(std::max< uint64_t >(1, restores)) << " (including the clock reads)\n";
+	std::cout << "allocations:  " << (after.allocations - before.allocations) << "\n";
+	std::cout << "rollbacks matched: " << (mismatches == 0 ? "yes" : "NO") << std::endl;
+}
+
+int main(int argc, char **argv) {
+	std::string mode = "bounc";
+	uint64_t ticks = 10000000;
+	float dt = 1.0f / 60.0f;
+	uint32_t boxes = 0; //0 => the game's own level
+	BouncSim::Collision collision = BouncSim::Collision::Grid;
+	bool sweep = false;
+	bool overlap = false;
+	uint32_t projectiles = 0;
+	uint32_t batch = 0;
+	bool endless = false;
+	bool rollback = false;
+	uint32_t workers = ThreadPool::default_workers();
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--ticks" && argi + 1 < argc) {
+			ticks = std::strtoull(argv[++argi], nullptr, 10);
+		} else if (arg == "--dt" && argi + 1 < argc) {
+			dt = std::strtof(argv[++argi], nullptr);
+		} else if (arg == "--boxes" && argi + 1 < argc) {
+			boxes = uint32_t(std::strtoul(argv[++argi], nullptr, 10));
+		} else if (arg == "--collision" && argi + 1 < argc) {
+			std::string path = argv[++argi];
+			if (path == "grid") collision = BouncSim::Collision::Grid;
+			else if (path == "simd") collision = BouncSim::Collision::Simd;
+			else if (path == "scalar") collision = BouncSim::Collision::Scalar;
+			else {
+				std::cerr << "unknown collision path '" << path << "'." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--box-sweep") {
+			sweep = true;
+		} else if (arg == "--overlap-bench") {
+			overlap = true;
+		} else if (arg == "--projectiles" && argi + 1 < argc) {
+			projectiles = uint32_t(std::strtoul(argv[++argi], nullptr, 10));
+		} else if (arg == "--endless") {
+			endless = true;
+		} else if (arg == "--rollback") {
+			rollback = true;
+		} else if (arg == "--batch" && argi + 1 < argc) {
+			batch = uint32_t(std::strtoul(argv[++argi], nullptr, 10));
+		} else if (arg == "--threads" && argi + 1 < argc) {
+			//(total threads, including the main one)
+			workers = std::max(1u, uint32_t(std::strtoul(argv[++argi], nullptr, 10))) - 1;
+		} else if (arg == "bounc" || arg == "pong") {
+			mode = arg;
+		} else {
+			std::cerr << "usage: " << argv[0] << " [bounc|pong] [--ticks N] [--dt SECONDS] [--boxes N] [--collision grid|simd|scalar] [--box-sweep] [--overlap-bench] [--projectiles N [--threads T]] [--batch N] [--endless] [--rollback]" << std::endl;
+			return 1;
+		}
+	}
+	if (ticks == 0 || !(dt > 0.0f)) {
+		std::cerr << "ticks and dt must be positive." << std::endl;
+		return 1;
+	}
+
+	if (overlap) {
+		overlap_bench();
+		return 0;
+	}
+	if (rollback) {
+		rollback_bench(ticks == 10000000 ? 1000000 : ticks, dt);
+		return 0;
+	}
+	if (endless) {
+		endless_bench(ticks == 10000000 ? 100000 : ticks, dt);
+		return 0;
+	}
+	if (batch) {
+		batch_bench(batch, ticks == 10000000 ? 10000 : ticks, dt);
+		return 0;
+	}
+	if (projectiles) {
+		projectile_bench(projectiles, workers, ticks == 10000000 ? 1000 : ticks, dt);
+		return 0;
+	}
+	if (sweep) {
+		box_sweep(ticks == 10000000 ? 200000 : ticks, dt);
+		return 0;
+	}
+
+	if (mode == "bounc") {
+		BouncSim sim;
+		if (boxes) make_level(sim, boxes);
+		sim.collision = collision;
+		BenchResult result = run(sim, drive_bounc, ticks, dt);
+		report(mode, result);
+		std::cout << "deaths:      " << sim.deaths << std::endl;
+	} else {
+		PongSim sim;
+		BenchResult result = run(sim, drive_pong, ticks, dt);
+		report(mode, result);
+		std::cout << "score:       " << sim.left_score << " - " << sim.right_score << std::endl;
+		//(doubles as a long-run check: the ball's speed is capped, so it must still be somewhere sensible)
+		if (!(std::isfinite(sim.ball.x) && std::isfinite(sim.ball.y) && std::isfinite(sim.ball_velocity.x) && std::isfinite(sim.ball_velocity.y))) {
+			std::cerr << "ERROR: ball is no longer finite after " << ticks << " ticks." << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
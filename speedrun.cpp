@@ -0,0 +1,272 @@
+//Speedrun solver:
+// searches for the fastest way through a B.O.U.N.C. level (reaching the right edge while grounded,
+// as BouncSim::update checks it) with a beam search over BouncState snapshots, expanded in parallel.
+// It doubles as the heaviest CPU benchmark for the simulation.
+//
+// usage: bounc-speedrun [--level FILE] [--beam N] [--decide TICKS] [--max-seconds S] [--threads T]
+//
+// Every 'decide' ticks, each state in the beam branches on every input:
+//   move (left / stand / right) x jump (or not; only when grounded) x fire (not, or at one of FireAngles angles).
+// Each child is simulated for 'decide' ticks (stopping early if it finishes); children that die are dropped,
+// identical children (same BouncSim::state_hash()) are merged, and the 'beam' furthest right are kept.
+// The first input sequence to finish is the answer; it's then replayed on a fresh BouncSim to check it.
+
+#include "BouncSim.hpp"
+#include "LevelFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+static constexpr float TickRate = 60.0f;
+static constexpr uint32_t FireAngles = 8;
+
+//an input, as bits: move (0 = stand, 1 = left, 2 = right), jump << 2, fire (0 = don't, else 1 + angle index) << 3:
+typedef uint8_t Action;
+static constexpr uint32_t ActionCount = 3 * 2 * (FireAngles + 1);
+
+static Action make_action(uint32_t index) {
+	uint32_t move = index % 3;
+	uint32_t jump = (index / 3) % 2;
+	uint32_t fire = index / 6;
+	return Action(move | jump << 2 | fire << 3);
+}
+
+//apply an input to the sim, the way the matching key presses / click would:
+static void apply(BouncSim &sim, Action action) {
+	uint32_t move = action & 3;
+	if (move == 1) sim.key_down(SDLK_a);
+	else if (move == 2) sim.key_down(SDLK_d);
+	else sim.key_up(SDLK_a);
+	if (action & 4) sim.key_down(SDLK_SPACE);
+	uint32_t fire = action >> 3;
+	if (fire) {
+		float angle = float(fire - 1) * (2.0f * 3.14159265f / FireAngles);
+		sim.fire(sim.player + glm::vec2(std::cos(angle), std::sin(angle)));
+	}
+}
+
+static std::string describe(Action action) {
+	static char const *moves[3] = {"stand", "left", "right"};
+	std::string ret = moves[action & 3];
+	if (action & 4) ret += " + jump";
+	if (action >> 3) ret += " + fire at " + std::to_string(int((action >> 3) - 1) * 360 / int(FireAngles)) + " deg";
+	return ret;
+}
+
+//one state in the beam, and how it got there:
+struct Node {
+	BouncState state;
+	uint64_t hash = 0;
+	uint32_t parent = 0; //index in the previous depth's beam
+	Action action = 0;
+	bool alive = false; //false for pruned children (jumped in the air, or died)
+	uint32_t finished = 0; //tick within the step at which the game was won (1-based), 0 if it wasn't
+};
+
+int main(int argc, char **argv) {
+	std::string level_filename;
+	uint32_t beam = 2048;
+	uint32_t decide = 6;
+	float max_seconds = 60.0f;
+	uint32_t workers = ThreadPool::default_workers();
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--level" && argi + 1 < argc) {
+			level_filename = argv[++argi];
+		} else if (arg == "--beam" && argi + 1 < argc) {
+			beam = std::max(1u, uint32_t(std::strtoul(argv[++argi], nullptr, 10)));
+		} else if (arg == "--decide" && argi + 1 < argc) {
+			decide = std::max(1u, uint32_t(std::strtoul(argv[++argi], nullptr, 10)));
+		} else if (arg == "--max-seconds" && argi + 1 < argc) {
+			max_seconds = std::strtof(argv[++argi], nullptr);
+		} else if (arg == "--threads" && argi + 1 < argc) {
+			//(total threads, including the main one)
+			workers = std::max(1u, uint32_t(std::strtoul(argv[++argi], nullptr, 10))) - 1;
+		} else {
+			std::cerr << "usage: " << argv[0] << " [--level FILE] [--beam N] [--decide TICKS] [--max-seconds S] [--threads T]" << std::endl;
+			return 1;
+		}
+	}
+
+	//the level every search state is played on:
+	BouncSim level;
+	if (!level_filename.empty()) {
+		try {
+			level.use_level_file(LevelFile::open(level_filename));
+		} catch (std::exception const &e) {
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	ThreadPool pool(workers);
+	//per-thread sims to step children on (restored from each parent's snapshot):
+	std::vector< BouncSim > sims(pool.threads(), level);
+
+	const float dt = 1.0f / TickRate;
+	const uint32_t max_depth = uint32_t(std::ceil(max_seconds * TickRate / decide));
+
+	std::vector< Node > frontier(1);
+	frontier[0].state = level.snapshot();
+	frontier[0].hash = level.state_hash();
+	frontier[0].alive = true;
+
+	//how each depth's beam was reached (parent index in the previous beam, and action), for reading back the winning inputs:
+	struct Step {
+		uint32_t parent;
+		Action action;
+	};
+	std::vector< std::vector< Step > > trail;
+	std::vector< Node > children;
+	std::vector< uint32_t > order;
+
+	uint64_t simulated_ticks = 0;
+	uint64_t expanded = 0;
+	uint64_t merged = 0;
+	uint32_t best_depth = 0, best_ticks = 0;
+	Node best;
+	bool found = false;
+
+	std::cout << "threads: " << pool.threads() << ", beam: " << beam << ", deciding every " << decide << " ticks" << std::endl;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t depth = 0; depth < max_depth && !found && !frontier.empty(); ++depth) {
+		//----- expand every beam state by every action, in parallel -----
+		// (child c is parent c / ActionCount, so results don't depend on which thread ran what)
+		children.resize(frontier.size() * ActionCount);
+		pool.parallel_for_stealing(uint32_t(children.size()), 16, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+			BouncSim &sim = sims[thread];
+			for (uint32_t c = begin; c < end; ++c) {
+				Node const &parent = frontier[c / ActionCount];
+				Node &child = children[c];
+				child.parent = c / ActionCount;
+				child.action = make_action(c % ActionCount);
+				child.alive = false;
+				child.finished = 0;
+
+				//(jumping only does anything when grounded, so skip the duplicates it would make)
+				if ((child.action & 4) && parent.state.player_state != BouncState::PlayerState::GROUND) continue;
+
+				sim.restore(parent.state);
+				apply(sim, child.action);
+				uint32_t deaths = sim.deaths;
+				for (uint32_t tick = 0; tick < decide; ++tick) {
+					sim.update(dt);
+					//(the game notices the win at the start of the update after the one that got there)
+					if (sim.has_ended) {
+						child.finished = tick + 1;
+						break;
+					}
+				}
+				if (sim.deaths != deaths) continue;
+				child.state = sim.snapshot();
+				child.hash = sim.state_hash();
+				child.alive = true;
+			}
+		});
+		expanded += children.size();
+		for (auto const &child : children) {
+			if (child.alive) simulated_ticks += (child.finished ? child.finished : decide);
+		}
+
+		//----- anything finished? (fewest ticks wins; ties go to the lowest index, to stay deterministic) -----
+		for (auto const &child : children) {
+			if (child.alive && child.finished && (!found || child.finished < best_ticks)) {
+				found = true;
+				best_depth = depth;
+				best_ticks = child.finished;
+				best = child;
+			}
+		}
+		if (found) break;
+
+		//----- keep the furthest-right distinct states -----
+		order.clear();
+		for (uint32_t c = 0; c < children.size(); ++c) {
+			if (children[c].alive) order.emplace_back(c);
+		}
+		//merge identical states, keeping the one with the lowest index (so the simplest input, e.g. not firing):
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			if (children[a].hash != children[b].hash) return children[a].hash < children[b].hash;
+			return a < b;
+		});
+		size_t before = order.size();
+		order.erase(std::unique(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			return children[a].hash == children[b].hash;
+		}), order.end());
+		//furthest right first (again preferring simpler inputs among equals):
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			if (children[a].state.player.x != children[b].state.player.x) return children[a].state.player.x > children[b].state.player.x;
+			return a < b;
+		});
+		merged += before - order.size();
+		if (order.size() > beam) order.resize(beam);
+
+		frontier.clear();
+		trail.emplace_back();
+		trail.back().reserve(order.size());
+		for (uint32_t c : order) {
+			frontier.emplace_back(children[c]);
+			trail.back().push_back(Step{ children[c].parent, children[c].action });
+		}
+
+		if ((depth + 1) % 50 == 0) {
+			std::cout << "  " << std::fixed << std::setprecision(1) << (depth + 1) * decide / TickRate << " s of game time: best x "
+				<< std::setprecision(2) << (frontier.empty() ? 0.0f : frontier[0].state.player.x) << std::endl;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration< double >(end - start).count();
+
+	std::cout << std::fixed;
+	std::cout << "searched:     " << expanded << " children (" << merged << " merged as duplicates)\n";
+	std::cout << "simulated:    " << simulated_ticks << " ticks in " << std::setprecision(3) << seconds << " s\n";
+	std::cout << "ticks/s:      " << std::setprecision(0) << simulated_ticks / seconds << std::endl;
+
+	if (!found) {
+		std::cout << "no finish found within " << std::setprecision(1) << max_seconds << " s of game time." << std::endl;
+		return 1;
+	}
+
+	//----- read back the inputs, from the winning child up to the root -----
+	std::vector< Action > actions;
+	actions.emplace_back(best.action);
+	for (uint32_t depth = best_depth, index = best.parent; depth > 0; --depth) {
+		//(the beam expanded at 'depth' was made at depth - 1)
+		Step const &step = trail[depth - 1][index];
+		actions.emplace_back(step.action);
+		index = step.parent;
+	}
+	std::reverse(actions.begin(), actions.end());
+
+	uint32_t total_ticks = best_depth * decide + best_ticks;
+	std::cout << "fastest:      " << total_ticks << " ticks (" << std::setprecision(3) << total_ticks / TickRate << " s)\n";
+	std::cout << "inputs (every " << decide << " ticks; only changes shown):\n";
+	for (uint32_t i = 0; i < actions.size(); ++i) {
+		if (i == 0 || actions[i] != actions[i-1] || (actions[i] >> 2)) {
+			std::cout << "  " << std::setw(7) << std::setprecision(2) << i * decide / TickRate << " s  " << describe(actions[i]) << "\n";
+		}
+	}
+
+	//----- check the route by playing it on a fresh sim -----
+	BouncSim check = level;
+	uint32_t ticks = 0;
+	for (Action action : actions) {
+		apply(check, action);
+		for (uint32_t tick = 0; tick < decide && !check.has_ended; ++tick) {
+			check.update(dt);
+			ticks += 1;
+		}
+	}
+	bool verified = (check.has_ended && ticks == total_ticks && check.deaths == 0);
+	std::cout << "replayed:     " << (verified ? "finishes in the same number of ticks" : "DOES NOT MATCH") << std::endl;
+
+	return (verified ? 0 : 1);
+}
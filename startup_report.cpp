@@ -0,0 +1,97 @@
+#include "startup_report.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	typedef std::chrono::steady_clock Clock; //(monotonic)
+
+	struct Entry {
+		char const *name;
+		uint32_t depth;
+		Clock::time_point begin;
+		Clock::time_point end;
+	};
+
+	std::atomic< bool > active{false};
+	std::thread::id thread; //only stages on the thread that called startup_report_begin() are recorded
+	Clock::time_point begin;
+	std::vector< Entry > entries;
+	uint32_t depth = 0;
+
+	bool recording() {
+		return active && std::this_thread::get_id() == thread;
+	}
+
+	double ms(Clock::time_point a, Clock::time_point b) {
+		return std::chrono::duration< double, std::milli >(b - a).count();
+	}
+}
+
+StartupStage::StartupStage(char const *name) {
+	if (!recording()) return;
+	index = int32_t(entries.size());
+	entries.emplace_back(Entry{name, depth, Clock::now(), Clock::time_point()});
+	depth += 1;
+}
+
+StartupStage::~StartupStage() {
+	if (index < 0 || !recording()) return;
+	entries[index].end = Clock::now();
+	depth -= 1;
+}
+
+void startup_report_begin() {
+	active = true;
+	thread = std::this_thread::get_id();
+	begin = Clock::now();
+	entries.clear();
+	depth = 0;
+}
+
+bool startup_report_active() {
+	return active;
+}
+
+void startup_report_end(std::ostream &to, bool json) {
+	if (!active) return;
+	Clock::time_point end = Clock::now();
+	active = false;
+
+	double total_ms = ms(begin, end);
+
+	//(the report sets its own number formatting; put back the caller's afterwards)
+	std::ios::fmtflags const flags = to.flags();
+	std::streamsize const precision = to.precision();
+
+	if (json) {
+		to << "{\n\t\"total_ms\": " << std::fixed << std::setprecision(3) << total_ms << ",\n\t\"stages\": [";
+		for (size_t i = 0; i < entries.size(); ++i) {
+			Entry const &e = entries[i];
+			to << (i ? ",\n" : "\n") << "\t\t{ \"name\": \"" << e.name << "\", \"depth\": " << e.depth
+				<< ", \"start_ms\": " << ms(begin, e.begin) << ", \"ms\": " << ms(e.begin, e.end) << " }";
+		}
+		to << "\n\t]\n}" << std::endl;
+	} else {
+		to << "Startup breakdown (nested stages are included in their parents):\n";
+		to << "  " << std::left << std::setw(40) << "stage" << std::right << std::setw(10) << "start ms" << std::setw(10) << "ms" << std::setw(8) << "%" << "\n";
+		for (Entry const &e : entries) {
+			double stage_ms = ms(e.begin, e.end);
+			to << "  " << std::left << std::setw(40) << (std::string(2 * e.depth, ' ') + e.name) << std::right << std::fixed
+				<< std::setprecision(2) << std::setw(10) << ms(begin, e.begin)
+				<< std::setw(10) << stage_ms
+				<< std::setprecision(1) << std::setw(8) << 100.0 * stage_ms / total_ms << "\n";
+		}
+		to << "  " << std::left << std::setw(40) << "total (time to first frame)" << std::right
+			<< std::setw(10) << "" << std::setprecision(2) << std::setw(10) << total_ms << std::endl;
+	}
+
+	to.flags(flags);
+	to.precision(precision);
+
+	entries.clear();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+ * Timing breakdown of program startup, printed by 'bounc --startup-report'.
+ *
+ * Usage:
+ *   startup_report_begin(); //start the clock (only the calling thread is timed)
+ *   { STARTUP_STAGE("thing"); ... } //times from here to end of scope; stages may nest
+ *   startup_report_end(std::cout, false); //print a table (or JSON) and stop recording
+ *
+ * Stages cost a single branch when no report was asked for, so they can stay in
+ *  code that also runs after startup (e.g., Mode constructors).
+ */
+
+#include <cstdint>
+#include <ostream>
+
+struct StartupStage {
+	//'name' must have static storage duration (e.g., a string literal):
+	explicit StartupStage(char const *name);
+	~StartupStage();
+
+	StartupStage(StartupStage const &) = delete;
+	StartupStage &operator=(StartupStage const &) = delete;
+
+	int32_t index = -1; //entry being timed, or -1 if not recording
+};
+
+void startup_report_begin();
+bool startup_report_active();
+//print each stage's duration and the total time since startup_report_begin(), then stop recording:
+void startup_report_end(std::ostream &to, bool json);
+
+#define STARTUP_STAGE_CONCAT2(A, B) A ## B
+#define STARTUP_STAGE_CONCAT(A, B) STARTUP_STAGE_CONCAT2(A, B)
+#define STARTUP_STAGE(NAME) StartupStage STARTUP_STAGE_CONCAT(startup_stage_, __LINE__)(NAME)
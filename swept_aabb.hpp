@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+
+/*
+ * Continuous (swept) collision between a moving box and a static one.
+ *
+ * The moving box has half-size 'radius' and center 'from', and moves with 'velocity'.
+ * If it first touches the static box [min,max] at some time in [0, max_t], returns true
+ *  and sets *t to that time and *axis to the axis of the face it hits (0 = x, 1 = y).
+ * Boxes that already overlap at time 0 (or that are touching and moving apart) don't count,
+ *  so callers still need a discrete overlap check for those.
+ */
+
+inline bool swept_aabb(glm::vec2 const &from, glm::vec2 const &radius, glm::vec2 const &velocity,
+	glm::vec2 const &min, glm::vec2 const &max, float max_t, float *t, int *axis) {
+
+	//sweep the center point against the static box grown by the moving box's radius:
+	glm::vec2 lo = min - radius;
+	glm::vec2 hi = max + radius;
+
+	float enter = -std::numeric_limits< float >::infinity();
+	float leave = std::numeric_limits< float >::infinity();
+	int enter_axis = 0;
+	for (int a = 0; a < 2; ++a) {
+		if (velocity[a] == 0.0f) {
+			//not moving on this axis, so must already be inside the slab:
+			if (from[a] < lo[a] || from[a] > hi[a]) return false;
+			continue;
+		}
+		float t0 = (lo[a] - from[a]) / velocity[a];
+		float t1 = (hi[a] - from[a]) / velocity[a];
+		if (t0 > t1) std::swap(t0, t1);
+		if (t0 > enter) {
+			enter = t0;
+			enter_axis = a;
+		}
+		leave = std::min(leave, t1);
+	}
+
+	if (!(enter <= leave)) return false; //slabs never overlap at the same time
+	if (enter < 0.0f || enter > max_t) return false; //overlapping already, or hits too late
+	if (!(leave > 0.0f)) return false; //only touching, and moving apart
+
+	*t = enter;
+	*axis = enter_axis;
+	return true;
+}